@@ -0,0 +1,538 @@
+// Benchmark of parsing, serialization and checksum routines on synthetic corpus
+//
+// Build: make bench (or cc -std=c99 -O2 -o bench bench.c -lm)
+// Usage: bench [--size BYTES] [--seed N] [--checksum-errors RATE] [--truncated RATE] [--over-length RATE]
+//              [--iterations N] [--strict] [--corpus-out FILE] [--output FILE]
+//
+// Library is compiled into this translation unit with malloc / free replaced by counting wrappers,
+// so every heap call of the library is seen (no linker or LD_PRELOAD support needed).
+// Results are written as JSON (stdout by default).
+
+#if !defined _WIN32 && !defined _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Interposing allocator
+
+typedef struct {
+    size_t malloc_count; // Number of malloc calls
+    size_t free_count; // Number of free calls
+    size_t live_bytes; // Currently allocated bytes
+    size_t peak_bytes; // Maximum of live_bytes since last reset
+} bench_heap;
+
+static bench_heap heap;
+
+#define BENCH_HEAP_HEADER 16 // Keeps returned blocks aligned as malloc does
+
+void* bench_malloc(size_t size) {
+    char* block = (char*)malloc(size + BENCH_HEAP_HEADER);
+    if(block == NULL) {
+        return NULL;
+    }
+    *(size_t*)block = size;
+    ++heap.malloc_count;
+    heap.live_bytes += size;
+    if(heap.live_bytes > heap.peak_bytes) {
+        heap.peak_bytes = heap.live_bytes;
+    }
+    return block + BENCH_HEAP_HEADER;
+}
+
+void bench_free(void* ptr) {
+    if(ptr == NULL) {
+        return;
+    }
+    char* block = (char*)ptr - BENCH_HEAP_HEADER;
+    ++heap.free_count;
+    heap.live_bytes -= *(size_t*)block;
+    free(block);
+}
+
+#define malloc(size) bench_malloc(size)
+#define free(ptr) bench_free(ptr)
+#include "nmea_parser.c"
+#undef malloc
+#undef free
+
+// Timer
+
+double bench_now() { // Seconds
+#ifdef _WIN32
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+#endif
+}
+
+// Corpus generator
+
+typedef struct {
+    size_t size; // Target corpus size (bytes)
+    unsigned long seed; // Random generator seed
+    double checksum_error_rate; // Fraction of sentences with corrupted checksum
+    double truncated_rate; // Fraction of sentences cut short (terminated without checksum)
+    double over_length_rate; // Fraction of sentences longer than NMEA_MESSAGE_MAX_LENGTH
+} bench_corpus_options;
+
+typedef struct {
+    char* data; // NUL terminated
+    size_t length; // Corpus length (bytes)
+    size_t capacity; // Allocated data size
+    size_t sentence_count; // Number of sentences
+    size_t checksum_error_count; // Number of sentences with corrupted checksum
+    size_t truncated_count; // Number of truncated sentences
+    size_t over_length_count; // Number of over-length sentences
+    uint64_t random; // xorshift64 state
+} bench_corpus;
+
+uint64_t bench_random(bench_corpus* corpus) {
+    corpus->random ^= corpus->random << 13;
+    corpus->random ^= corpus->random >> 7;
+    corpus->random ^= corpus->random << 17;
+    return corpus->random;
+}
+
+double bench_random_unit(bench_corpus* corpus) { // [0, 1)
+    return (double)(bench_random(corpus) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+int bench_corpus_add(bench_corpus* corpus, const bench_corpus_options* options, const char* body) { // body is sentence without "$", "*" and checksum
+    char line[256];
+    size_t length = strlen(body);
+    const double kind = bench_random_unit(corpus);
+
+    if(kind < options->truncated_rate) { // Receiver lost the rest of the sentence
+        length = 1 + (size_t)(bench_random(corpus) % (length - 1));
+        snprintf(line, sizeof(line), "$%.*s\r\n", (int)length, body);
+        ++corpus->truncated_count;
+    } else {
+        char padded[192];
+        if(kind < options->truncated_rate + options->over_length_rate) { // Vendor firmware appending extra fields
+            size_t target = NMEA_MESSAGE_MAX_LENGTH + 1 + (size_t)(bench_random(corpus) % 40);
+            snprintf(padded, sizeof(padded), "%s", body);
+            while(length < target && length + 5 < sizeof(padded)) {
+                memcpy(padded + length, ",0000", 6);
+                length += 5;
+            }
+            body = padded;
+            ++corpus->over_length_count;
+        }
+
+        int checksum = nmea_checksum_scalar(body, body + length);
+        if(kind >= options->truncated_rate + options->over_length_rate
+            && kind < options->truncated_rate + options->over_length_rate + options->checksum_error_rate) {
+            checksum ^= 1 + (int)(bench_random(corpus) % 255); // Any other value
+            ++corpus->checksum_error_count;
+        }
+        snprintf(line, sizeof(line), "$%s*%02X\r\n", body, checksum);
+    }
+
+    const size_t line_length = strlen(line);
+    if(corpus->length + line_length + 1 > corpus->capacity) {
+        const size_t capacity = corpus->capacity * 2 + line_length + 1;
+        char* data = (char*)realloc(corpus->data, capacity);
+        if(data == NULL) {
+            return NMEA_ALLOCATION_ERROR;
+        }
+        corpus->data = data;
+        corpus->capacity = capacity;
+    }
+    memcpy(corpus->data + corpus->length, line, line_length + 1);
+    corpus->length += line_length;
+    ++corpus->sentence_count;
+    return NMEA_SUCCESS;
+}
+
+int bench_generate_corpus(bench_corpus* corpus, const bench_corpus_options* options) {
+    memset(corpus, 0, sizeof(*corpus));
+    corpus->random = 0x9E3779B97F4A7C15ull ^ options->seed;
+
+    // One receiver epoch per second: GGA, GSA, GSV (3 sentences, 11 satellites) and RMC
+    double lat = 5321.6802;
+    double lon = 630.3372;
+    int satellites[11][4];
+    for(size_t i = 0; i < 11; ++i) {
+        satellites[i][0] = 1 + (int)i * 3 + (int)(bench_random(corpus) % 3); // Unique PRN
+        satellites[i][1] = (int)(bench_random(corpus) % 90);
+        satellites[i][2] = (int)(bench_random(corpus) % 360);
+        satellites[i][3] = 10 + (int)(bench_random(corpus) % 40);
+    }
+
+    char body[160];
+    for(unsigned long epoch = 0; corpus->length < options->size; ++epoch) {
+        const unsigned long seconds = epoch % 86400;
+        char time_str[16];
+        snprintf(time_str, sizeof(time_str), "%02lu%02lu%02lu.000", seconds / 3600, seconds / 60 % 60, seconds % 60);
+        lat += (bench_random_unit(corpus) - 0.5) * 0.001;
+        lon += (bench_random_unit(corpus) - 0.5) * 0.001;
+        const int sats_used = 4 + (int)(bench_random(corpus) % 8);
+
+        snprintf(body, sizeof(body), "GPGGA,%s,%09.4f,N,%010.4f,W,1,%02d,%.2f,%.1f,M,55.2,M,,",
+            time_str, lat, lon, sats_used, 0.8 + bench_random_unit(corpus), 50.0 + 20.0 * bench_random_unit(corpus));
+        int return_value = bench_corpus_add(corpus, options, body);
+
+        int length = snprintf(body, sizeof(body), "GPGSA,A,3");
+        for(int i = 0; i < 12; ++i) {
+            if(i < sats_used) {
+                length += snprintf(body + length, sizeof(body) - (size_t)length, ",%02d", satellites[i % 11][0]);
+            } else {
+                length += snprintf(body + length, sizeof(body) - (size_t)length, ",");
+            }
+        }
+        snprintf(body + length, sizeof(body) - (size_t)length, ",1.72,1.03,1.38");
+        if(return_value == NMEA_SUCCESS) {
+            return_value = bench_corpus_add(corpus, options, body);
+        }
+
+        for(int message = 0; message < 3 && return_value == NMEA_SUCCESS; ++message) {
+            length = snprintf(body, sizeof(body), "GPGSV,3,%d,11", message + 1);
+            for(int i = message * 4; i < message * 4 + 4 && i < 11; ++i) {
+                length += snprintf(body + length, sizeof(body) - (size_t)length, ",%02d,%02d,%03d,%02d",
+                    satellites[i][0], satellites[i][1], satellites[i][2], satellites[i][3]);
+            }
+            return_value = bench_corpus_add(corpus, options, body);
+        }
+
+        snprintf(body, sizeof(body), "GPRMC,%s,A,%09.4f,N,%010.4f,W,%.2f,%.2f,280511,,,A",
+            time_str, lat, lon, bench_random_unit(corpus), 360.0 * bench_random_unit(corpus));
+        if(return_value == NMEA_SUCCESS) {
+            return_value = bench_corpus_add(corpus, options, body);
+        }
+
+        if(return_value != NMEA_SUCCESS) {
+            free(corpus->data);
+            return return_value;
+        }
+    }
+    return NMEA_SUCCESS;
+}
+
+// Measurements
+
+typedef struct {
+    const char* name;
+    size_t sentences; // Sentences processed per iteration
+    size_t bytes; // Bytes processed per iteration
+    size_t errors; // Sentences rejected per iteration
+    double seconds; // Best iteration time
+    size_t malloc_count; // Heap calls per iteration
+    size_t peak_heap; // Largest heap use of single sentence (bytes)
+} bench_result;
+
+typedef struct {
+    const bench_corpus* corpus;
+    int strict;
+    nmea_message** messages; // Parsed valid messages (serialization input)
+    size_t message_count;
+    size_t message_bytes; // Serialized length of parsed messages
+    const char** bodies; // Sentence bodies (checksum input)
+    size_t* body_lengths;
+    size_t body_count;
+    size_t body_bytes;
+} bench_context;
+
+void bench_heap_begin_sentence() {
+    heap.peak_bytes = heap.live_bytes;
+}
+
+void bench_heap_end_sentence(bench_result* result, const size_t base) {
+    if(heap.peak_bytes - base > result->peak_heap) {
+        result->peak_heap = heap.peak_bytes - base;
+    }
+}
+
+void bench_parse(bench_context* context, bench_result* result, const int count_heap) {
+    const char* str = context->corpus->data;
+    size_t offset = 0;
+    size_t message_end_index = 0;
+    result->sentences = 0;
+    result->errors = 0;
+
+    for(;;) {
+        const size_t base = heap.live_bytes;
+        if(count_heap != 0) {
+            bench_heap_begin_sentence();
+        }
+
+        nmea_message* message = NULL;
+        const int return_value = nmea_parse_message(str + offset, &message, &message_end_index, context->strict, NULL);
+        if(message != NULL) {
+            nmea_destroy_message(&message);
+        }
+
+        if(count_heap != 0) {
+            bench_heap_end_sentence(result, base);
+        }
+        if(message_end_index == 0) { // No more messages
+            break;
+        }
+        offset += message_end_index; // Set on errors too
+        if(return_value == NMEA_MESSAGE_BEGIN_DELIMITER_NOT_FOUND) { // Line terminator left after last message
+            continue;
+        }
+        ++result->sentences;
+        if(return_value != NMEA_SUCCESS) {
+            ++result->errors;
+        }
+    }
+    result->bytes = offset;
+}
+
+void bench_to_string(bench_context* context, bench_result* result, const int count_heap) {
+    result->sentences = 0;
+    result->errors = 0;
+    for(size_t i = 0; i < context->message_count; ++i) {
+        const size_t base = heap.live_bytes;
+        if(count_heap != 0) {
+            bench_heap_begin_sentence();
+        }
+
+        char* message_str = NULL;
+        if(nmea_message_to_string(context->messages[i], &message_str) == NMEA_SUCCESS) {
+            nmea_destroy_message_string(&message_str);
+        } else {
+            ++result->errors;
+        }
+
+        if(count_heap != 0) {
+            bench_heap_end_sentence(result, base);
+        }
+        ++result->sentences;
+    }
+    result->bytes = context->message_bytes;
+}
+
+static volatile int bench_sink; // Keeps checksum loops from being optimized out
+
+void bench_checksum(bench_context* context, bench_result* result, int(*checksum)(const char* begin, const char* end)) {
+    int accumulated = 0;
+    for(size_t i = 0; i < context->body_count; ++i) {
+        accumulated ^= checksum(context->bodies[i], context->bodies[i] + context->body_lengths[i]);
+    }
+    bench_sink = accumulated;
+    result->sentences = context->body_count;
+    result->bytes = context->body_bytes;
+    result->errors = 0;
+}
+
+void bench_checksum_kernel(bench_context* context, bench_result* result, const int count_heap) {
+    (void)count_heap;
+    bench_checksum(context, result, NMEA_SCAN.checksum);
+}
+
+void bench_checksum_scalar(bench_context* context, bench_result* result, const int count_heap) {
+    (void)count_heap;
+    bench_checksum(context, result, nmea_checksum_scalar);
+}
+
+void bench_run(bench_context* context, bench_result* result, const size_t iterations, void(*function)(bench_context*, bench_result*, const int)) {
+    // Heap metrics come from separate pass, so timed iterations only pay for counter updates
+    const size_t malloc_count = heap.malloc_count;
+    result->peak_heap = 0;
+    function(context, result, 1);
+    result->malloc_count = heap.malloc_count - malloc_count;
+
+    result->seconds = 0.0;
+    for(size_t i = 0; i < iterations; ++i) {
+        const double begin = bench_now();
+        function(context, result, 0);
+        const double seconds = bench_now() - begin;
+        if(i == 0 || seconds < result->seconds) {
+            result->seconds = seconds;
+        }
+    }
+}
+
+int bench_prepare(bench_context* context) { // Collects serialization and checksum inputs (not timed)
+    const bench_corpus* corpus = context->corpus;
+    context->messages = (nmea_message**)malloc(corpus->sentence_count * sizeof(nmea_message*));
+    context->bodies = (const char**)malloc(corpus->sentence_count * sizeof(const char*));
+    context->body_lengths = (size_t*)malloc(corpus->sentence_count * sizeof(size_t));
+    if(context->messages == NULL || context->bodies == NULL || context->body_lengths == NULL) {
+        return NMEA_ALLOCATION_ERROR;
+    }
+
+    const char* str = corpus->data;
+    size_t offset = 0;
+    size_t message_end_index = 0;
+    for(;;) {
+        nmea_message* message = NULL;
+        const int return_value = nmea_parse_message(str + offset, &message, &message_end_index, context->strict, NULL);
+        if(return_value == NMEA_SUCCESS) {
+            size_t message_length = 0;
+            nmea_message_length(message, &message_length);
+            context->messages[context->message_count++] = message;
+            context->message_bytes += message_length;
+        } else if(message != NULL) {
+            nmea_destroy_message(&message);
+        }
+        if(message_end_index == 0) {
+            break;
+        }
+        offset += message_end_index;
+    }
+
+    for(const char* line = str; *line != '\0';) {
+        const char* line_end = strchr(line, '\n');
+        line_end = line_end != NULL ? line_end : line + strlen(line);
+        const char* checksum_delimiter = memchr(line, '*', (size_t)(line_end - line));
+        context->bodies[context->body_count] = line + 1;
+        context->body_lengths[context->body_count] = (size_t)((checksum_delimiter != NULL ? checksum_delimiter : line_end) - line - 1);
+        context->body_bytes += context->body_lengths[context->body_count];
+        ++context->body_count;
+        line = *line_end != '\0' ? line_end + 1 : line_end;
+    }
+    return NMEA_SUCCESS;
+}
+
+void bench_release(bench_context* context) {
+    for(size_t i = 0; i < context->message_count; ++i) {
+        nmea_destroy_message(&context->messages[i]);
+    }
+    free(context->messages);
+    free((void*)context->bodies);
+    free(context->body_lengths);
+}
+
+// Report
+
+void bench_write_result(FILE* output, const bench_result* result, const int last) {
+    const double sentences = result->sentences != 0 ? (double)result->sentences : 1.0;
+    const double seconds = result->seconds > 0.0 ? result->seconds : 1e-9;
+    fprintf(output, "    {\n");
+    fprintf(output, "      \"name\": \"%s\",\n", result->name);
+    fprintf(output, "      \"sentences\": %zu,\n", result->sentences);
+    fprintf(output, "      \"bytes\": %zu,\n", result->bytes);
+    fprintf(output, "      \"errors\": %zu,\n", result->errors);
+    fprintf(output, "      \"seconds\": %.9f,\n", result->seconds);
+    fprintf(output, "      \"sentences_per_sec\": %.1f,\n", (double)result->sentences / seconds);
+    fprintf(output, "      \"bytes_per_sec\": %.1f,\n", (double)result->bytes / seconds);
+    fprintf(output, "      \"ns_per_sentence\": %.3f,\n", result->seconds * 1e9 / sentences);
+    fprintf(output, "      \"mallocs_per_sentence\": %.3f,\n", (double)result->malloc_count / sentences);
+    fprintf(output, "      \"peak_heap_per_sentence\": %zu\n", result->peak_heap);
+    fprintf(output, "    }%s\n", last != 0 ? "" : ",");
+}
+
+int main(int argc, char** argv) {
+    bench_corpus_options options = { 16u << 20, 1, 0.01, 0.01, 0.01 };
+    size_t iterations = 5;
+    int strict = 0;
+    const char* corpus_path = NULL;
+    const char* output_path = NULL;
+
+    for(int i = 1; i < argc; ++i) {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if(strcmp(argv[i], "--strict") == 0) {
+            strict = 1;
+            continue;
+        }
+        if(value == NULL) {
+            fprintf(stderr, "Missing value of %s\n", argv[i]);
+            return 1;
+        }
+        if(strcmp(argv[i], "--size") == 0) {
+            options.size = (size_t)strtoull(value, NULL, 10);
+        } else if(strcmp(argv[i], "--seed") == 0) {
+            options.seed = strtoul(value, NULL, 10);
+        } else if(strcmp(argv[i], "--checksum-errors") == 0) {
+            options.checksum_error_rate = strtod(value, NULL);
+        } else if(strcmp(argv[i], "--truncated") == 0) {
+            options.truncated_rate = strtod(value, NULL);
+        } else if(strcmp(argv[i], "--over-length") == 0) {
+            options.over_length_rate = strtod(value, NULL);
+        } else if(strcmp(argv[i], "--iterations") == 0) {
+            iterations = (size_t)strtoull(value, NULL, 10);
+        } else if(strcmp(argv[i], "--corpus-out") == 0) {
+            corpus_path = value;
+        } else if(strcmp(argv[i], "--output") == 0) {
+            output_path = value;
+        } else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+        ++i;
+    }
+    iterations = iterations != 0 ? iterations : 1;
+
+    bench_corpus corpus;
+    if(bench_generate_corpus(&corpus, &options) != NMEA_SUCCESS) {
+        fprintf(stderr, "Corpus allocation failed\n");
+        return 1;
+    }
+
+    if(corpus_path != NULL) {
+        FILE* file = fopen(corpus_path, "wb");
+        if(file == NULL || fwrite(corpus.data, 1, corpus.length, file) != corpus.length) {
+            fprintf(stderr, "Cannot write %s\n", corpus_path);
+            return 1;
+        }
+        fclose(file);
+    }
+
+    bench_context context;
+    memset(&context, 0, sizeof(context));
+    context.corpus = &corpus;
+    context.strict = strict;
+    if(bench_prepare(&context) != NMEA_SUCCESS) {
+        fprintf(stderr, "Allocation failed\n");
+        return 1;
+    }
+
+    bench_result results[] = {
+        { "nmea_parse_message", 0, 0, 0, 0.0, 0, 0 },
+        { "nmea_message_to_string", 0, 0, 0, 0.0, 0, 0 },
+        { "checksum", 0, 0, 0, 0.0, 0, 0 }, // Kernel selected at runtime
+        { "checksum_scalar", 0, 0, 0, 0.0, 0, 0 }
+    };
+    bench_run(&context, &results[0], iterations, bench_parse);
+    bench_run(&context, &results[1], iterations, bench_to_string);
+    bench_run(&context, &results[2], iterations, bench_checksum_kernel);
+    bench_run(&context, &results[3], iterations, bench_checksum_scalar);
+
+    FILE* output = output_path != NULL ? fopen(output_path, "w") : stdout;
+    if(output == NULL) {
+        fprintf(stderr, "Cannot write %s\n", output_path);
+        return 1;
+    }
+
+    fprintf(output, "{\n");
+    fprintf(output, "  \"corpus\": {\n");
+    fprintf(output, "    \"bytes\": %zu,\n", corpus.length);
+    fprintf(output, "    \"sentences\": %zu,\n", corpus.sentence_count);
+    fprintf(output, "    \"seed\": %lu,\n", options.seed);
+    fprintf(output, "    \"checksum_errors\": %zu,\n", corpus.checksum_error_count);
+    fprintf(output, "    \"truncated\": %zu,\n", corpus.truncated_count);
+    fprintf(output, "    \"over_length\": %zu\n", corpus.over_length_count);
+    fprintf(output, "  },\n");
+    fprintf(output, "  \"strict\": %d,\n", strict);
+    fprintf(output, "  \"iterations\": %zu,\n", iterations);
+    fprintf(output, "  \"results\": [\n");
+    for(size_t i = 0; i < sizeof(results) / sizeof(results[0]); ++i) {
+        bench_write_result(output, &results[i], i + 1 == sizeof(results) / sizeof(results[0]));
+    }
+    fprintf(output, "  ]\n");
+    fprintf(output, "}\n");
+
+    if(output != stdout) {
+        fclose(output);
+    }
+    bench_release(&context);
+    free(corpus.data);
+    return 0;
+}
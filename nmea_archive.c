@@ -0,0 +1,434 @@
+#include "nmea_archive.h"
+
+#include <string.h>
+
+static const char nmea_archive_data_magic[8] = { 'N', 'M', 'E', 'A', 'A', 'R', 'C', '1' };
+static const char nmea_archive_index_magic[8] = { 'N', 'M', 'E', 'A', 'I', 'D', 'X', '1' };
+static const uint32_t nmea_archive_byte_order = 0x01020304u; // Files are written in host byte order; Reader rejects foreign order
+
+#define NMEA_ARCHIVE_DAY_MS UINT64_C(86400000)
+
+// Sentence ID packing: 6 bits per character (NUL = 0, " " - "^" = 1 - 63), talker ID in high 12 bits, type code in low 18 bits
+
+#define NMEA_ARCHIVE_TYPE_MASK 0x3FFFFu
+#define NMEA_ARCHIVE_ID_MASK 0x3FFFFFFFu
+
+int nmea_archive_pack_chars(const char* str, const size_t count, uint32_t* packed) { // Characters after NUL (or all if str is NULL) pack as NUL
+    int ended = str == NULL;
+    for(size_t i = 0; i < count; ++i) {
+        const char c = ended ? '\0' : str[i];
+        if(c == '\0') {
+            ended = 1;
+            *packed <<= 6;
+        } else if(c < ' ' || c > '^') {
+            return NMEA_UNSUPPORTED_MESSAGE;
+        } else {
+            *packed = *packed << 6 | (uint32_t)(c - ' ' + 1);
+        }
+    }
+    return NMEA_SUCCESS;
+}
+
+char nmea_archive_unpack_char(const uint32_t packed, const unsigned shift) {
+    const uint32_t value = packed >> shift & 0x3F;
+    return value == 0 ? '\0' : (char)(value - 1 + ' ');
+}
+
+int nmea_archive_pack_id(const char* talker_id, const char* type_code, uint32_t* packed) { // talker_id can be NULL (type code only)
+    *packed = 0;
+    const int return_value = nmea_archive_pack_chars(talker_id, 2, packed);
+    return return_value != NMEA_SUCCESS ? return_value : nmea_archive_pack_chars(type_code, 3, packed);
+}
+
+uint64_t nmea_archive_type_bit(const uint32_t packed) { // Type code hashed to one of 64 index bits (Fibonacci hashing)
+    return UINT64_C(1) << (((packed & NMEA_ARCHIVE_TYPE_MASK) * 0x9E3779B1u) >> 26);
+}
+
+// Writer
+
+const nmea_value* nmea_archive_value_at(const nmea_message* message, size_t index) {
+    const nmea_value* value = message->first_value;
+    while(value != NULL && index-- != 0) {
+        value = value->next_value;
+    }
+    return value;
+}
+
+int nmea_archive_value_to_uint(const nmea_message* message, const size_t index, const size_t length, uint32_t* number) { // Value of exactly length digits
+    const nmea_value* value = nmea_archive_value_at(message, index);
+    if(value == NULL || value->value_length != length) {
+        return NMEA_FIELD_VALUE_INCORRECT;
+    }
+    return nmea_field_to_uint(value->value, value->value_length, number);
+}
+
+int nmea_archive_message_date(const nmea_message* message, uint32_t* date) {
+    if(memcmp(message->type_code, "RMC", 3) == 0) {
+        const nmea_value* value = nmea_archive_value_at(message, 8);
+        return value != NULL ? nmea_field_to_days(value->value, value->value_length, date) : NMEA_FIELD_COUNT_INCORRECT;
+    }
+
+    if(memcmp(message->type_code, "ZDA", 3) == 0) { // hhmmss.ss,dd,mm,yyyy
+        uint32_t day;
+        uint32_t month;
+        uint32_t year;
+        int return_value;
+        if((return_value = nmea_archive_value_to_uint(message, 1, 2, &day)) != NMEA_SUCCESS
+            || (return_value = nmea_archive_value_to_uint(message, 2, 2, &month)) != NMEA_SUCCESS
+            || (return_value = nmea_archive_value_to_uint(message, 3, 4, &year)) != NMEA_SUCCESS) {
+            return return_value;
+        }
+        const char ddmmyy[6] = {
+            (char)('0' + day / 10), (char)('0' + day % 10),
+            (char)('0' + month / 10), (char)('0' + month % 10),
+            (char)('0' + year / 10 % 10), (char)('0' + year % 10)
+        };
+        return nmea_field_to_days(ddmmyy, sizeof(ddmmyy), date);
+    }
+
+    return NMEA_UNSUPPORTED_MESSAGE;
+}
+
+uint64_t nmea_archive_time_key(nmea_archive_writer* writer, const nmea_message* message) {
+    size_t time_index;
+    if(memcmp(message->type_code, "GGA", 3) == 0 || memcmp(message->type_code, "RMC", 3) == 0
+        || memcmp(message->type_code, "GNS", 3) == 0 || memcmp(message->type_code, "GST", 3) == 0
+        || memcmp(message->type_code, "ZDA", 3) == 0) {
+        time_index = 0;
+    } else if(memcmp(message->type_code, "GLL", 3) == 0) {
+        time_index = 4;
+    } else {
+        return writer->time_key;
+    }
+
+    const nmea_value* value = nmea_archive_value_at(message, time_index);
+    uint32_t time_ms;
+    if(value == NULL || nmea_field_to_time_ms(value->value, value->value_length, &time_ms) != NMEA_SUCCESS) {
+        return writer->time_key;
+    }
+
+    uint32_t date;
+    if(nmea_archive_message_date(message, &date) == NMEA_SUCCESS) {
+        writer->date = date;
+    } else if(writer->date != NMEA_DATE_INVALID && writer->time_ms != NMEA_TIME_INVALID
+        && time_ms + 43200000u < writer->time_ms) { // Midnight passed before next RMC / ZDA
+        ++writer->date;
+    }
+    writer->time_ms = time_ms;
+
+    writer->time_key = (writer->date != NMEA_DATE_INVALID ? writer->date * NMEA_ARCHIVE_DAY_MS : 0) + time_ms;
+    return writer->time_key;
+}
+
+int nmea_archive_write_header(FILE* file, const char* magic, const uint32_t value) {
+    return fwrite(magic, 1, 8, file) == 8
+        && fwrite(&nmea_archive_byte_order, sizeof(uint32_t), 1, file) == 1
+        && fwrite(&value, sizeof(uint32_t), 1, file) == 1
+        ? NMEA_SUCCESS : NMEA_FILE_ERROR;
+}
+
+int nmea_archive_open_writer(nmea_archive_writer* writer, const char* data_path, const char* index_path) {
+    if(writer == NULL || data_path == NULL || index_path == NULL) {
+        return NMEA_ASSERTION_FAILED;
+    }
+
+    writer->index = NULL;
+    if((writer->data = fopen(data_path, "wb")) == NULL
+        || (writer->index = fopen(index_path, "wb")) == NULL
+        || nmea_archive_write_header(writer->data, nmea_archive_data_magic, 0) != NMEA_SUCCESS
+        || nmea_archive_write_header(writer->index, nmea_archive_index_magic, NMEA_ARCHIVE_INDEX_INTERVAL) != NMEA_SUCCESS) {
+        if(writer->data != NULL) {
+            fclose(writer->data);
+        }
+        if(writer->index != NULL) {
+            fclose(writer->index);
+        }
+        writer->data = NULL;
+        writer->index = NULL;
+        return NMEA_FILE_ERROR;
+    }
+
+    writer->offset = NMEA_ARCHIVE_HEADER_SIZE;
+    writer->time_key = 0;
+    writer->time_ms = NMEA_TIME_INVALID;
+    writer->date = NMEA_DATE_INVALID;
+    writer->block_records = 0;
+    writer->block.max_key = 0;
+    return NMEA_SUCCESS;
+}
+
+int nmea_archive_append(nmea_archive_writer* writer, const nmea_message* message) {
+    if(writer == NULL || writer->data == NULL || message == NULL) {
+        return NMEA_ASSERTION_FAILED;
+    }
+
+    uint32_t id;
+    int return_value = nmea_archive_pack_id(message->talker_id, message->type_code, &id);
+    if(return_value != NMEA_SUCCESS) {
+        return return_value;
+    }
+    if(message->value_count > UINT16_MAX) {
+        return NMEA_FIELD_COUNT_INCORRECT;
+    }
+
+    uint32_t record_length = NMEA_ARCHIVE_RECORD_HEADER_SIZE;
+    for(const nmea_value* value = message->first_value; value != NULL; value = value->next_value) {
+        if(value->value_length > NMEA_ARCHIVE_MAX_VALUE_LENGTH) {
+            return NMEA_FIELD_VALUE_INCORRECT;
+        }
+        record_length += 1 + (uint32_t)value->value_length;
+    }
+    const size_t padding = (4 - record_length % 4) % 4;
+    record_length += (uint32_t)padding;
+
+    const uint64_t time_key = nmea_archive_time_key(writer, message);
+
+    uint8_t header[NMEA_ARCHIVE_RECORD_HEADER_SIZE];
+    const uint16_t value_count = (uint16_t)message->value_count;
+    memcpy(header, &record_length, 4);
+    memcpy(header + 4, &id, 4);
+    memcpy(header + 8, &time_key, 8);
+    memcpy(header + 16, &value_count, 2);
+    header[18] = (uint8_t)message->start_delimiter;
+    header[19] = 0;
+
+    static const uint8_t zeros[4] = { 0, 0, 0, 0 };
+    int written = fwrite(header, 1, sizeof(header), writer->data) == sizeof(header);
+    for(const nmea_value* value = message->first_value; written && value != NULL; value = value->next_value) {
+        const uint8_t length = (uint8_t)value->value_length;
+        written = fwrite(&length, 1, 1, writer->data) == 1
+            && fwrite(value->value, 1, length, writer->data) == length;
+    }
+    if(!written || fwrite(zeros, 1, padding, writer->data) != padding) {
+        return NMEA_FILE_ERROR;
+    }
+
+    if(writer->block_records == 0) {
+        writer->block.offset = writer->offset;
+        writer->block.min_key = time_key;
+        writer->block.types = 0;
+    } else if(time_key < writer->block.min_key) {
+        writer->block.min_key = time_key;
+    }
+    if(time_key > writer->block.max_key) {
+        writer->block.max_key = time_key; // Running maximum is kept across blocks
+    }
+    writer->block.types |= nmea_archive_type_bit(id);
+    writer->offset += record_length;
+
+    if(++writer->block_records == NMEA_ARCHIVE_INDEX_INTERVAL) {
+        writer->block_records = 0;
+        if(fwrite(&writer->block, sizeof(writer->block), 1, writer->index) != 1) {
+            return NMEA_FILE_ERROR;
+        }
+    }
+    return NMEA_SUCCESS;
+}
+
+int nmea_archive_close_writer(nmea_archive_writer* writer) {
+    if(writer == NULL || writer->data == NULL) {
+        return NMEA_ASSERTION_FAILED;
+    }
+
+    int return_value = NMEA_SUCCESS;
+    if(writer->block_records != 0 && fwrite(&writer->block, sizeof(writer->block), 1, writer->index) != 1) {
+        return_value = NMEA_FILE_ERROR;
+    }
+    if(fclose(writer->data) != 0 || fclose(writer->index) != 0) { // Buffered write errors show up here
+        return_value = NMEA_FILE_ERROR;
+    }
+    writer->data = NULL;
+    writer->index = NULL;
+    return return_value;
+}
+
+// Reader
+
+int nmea_archive_check_header(const nmea_mapped_file* mapped, const char* magic) {
+    uint32_t byte_order;
+    if(mapped->size < NMEA_ARCHIVE_HEADER_SIZE || memcmp(mapped->data, magic, 8) != 0) {
+        return NMEA_ARCHIVE_FORMAT_INCORRECT;
+    }
+    memcpy(&byte_order, mapped->data + 8, sizeof(byte_order));
+    return byte_order == nmea_archive_byte_order ? NMEA_SUCCESS : NMEA_ARCHIVE_FORMAT_INCORRECT;
+}
+
+int nmea_archive_open_reader(nmea_archive_reader* reader, const char* data_path, const char* index_path) {
+    if(reader == NULL || data_path == NULL || index_path == NULL) {
+        return NMEA_ASSERTION_FAILED;
+    }
+
+    int return_value = nmea_map_file(data_path, &reader->data);
+    if(return_value != NMEA_SUCCESS) {
+        return return_value;
+    }
+    if((return_value = nmea_map_file(index_path, &reader->index)) != NMEA_SUCCESS) {
+        nmea_unmap_file(&reader->data);
+        return return_value;
+    }
+
+    uint32_t interval = 0;
+    if((return_value = nmea_archive_check_header(&reader->data, nmea_archive_data_magic)) == NMEA_SUCCESS
+        && (return_value = nmea_archive_check_header(&reader->index, nmea_archive_index_magic)) == NMEA_SUCCESS) {
+        memcpy(&interval, reader->index.data + 12, sizeof(interval));
+    }
+    if(return_value != NMEA_SUCCESS || interval == 0
+        || (reader->index.size - NMEA_ARCHIVE_HEADER_SIZE) % sizeof(nmea_archive_index_entry) != 0) {
+        nmea_unmap_file(&reader->index);
+        nmea_unmap_file(&reader->data);
+        return NMEA_ARCHIVE_FORMAT_INCORRECT;
+    }
+
+    reader->entries = (const nmea_archive_index_entry*)(const void*)(reader->index.data + NMEA_ARCHIVE_HEADER_SIZE); // Mapping is page aligned
+    reader->entry_count = (reader->index.size - NMEA_ARCHIVE_HEADER_SIZE) / sizeof(nmea_archive_index_entry);
+    return NMEA_SUCCESS;
+}
+
+int nmea_archive_close_reader(nmea_archive_reader* reader) {
+    if(reader == NULL) {
+        return NMEA_ASSERTION_FAILED;
+    }
+
+    nmea_unmap_file(&reader->index);
+    nmea_unmap_file(&reader->data);
+    reader->entries = NULL;
+    reader->entry_count = 0;
+    return NMEA_SUCCESS;
+}
+
+int nmea_archive_seek(const nmea_archive_reader* reader
+    , nmea_archive_cursor* cursor
+    , const uint64_t begin_key
+    , const uint64_t end_key
+    , const char* id) {
+    if(reader == NULL || cursor == NULL) {
+        return NMEA_ASSERTION_FAILED;
+    }
+
+    cursor->reader = reader;
+    cursor->begin_key = begin_key;
+    cursor->end_key = end_key;
+    cursor->id = 0;
+    cursor->id_mask = 0;
+    cursor->type_bit = ~UINT64_C(0);
+
+    if(id != NULL) {
+        const size_t length = strlen(id);
+        if(length != 3 && length != 5) {
+            return NMEA_MESSAGE_ID_LENGTH_INCORRECT;
+        }
+        const int return_value = nmea_archive_pack_id(length == 5 ? id : NULL, id + length - 3, &cursor->id);
+        if(return_value != NMEA_SUCCESS) {
+            return return_value;
+        }
+        cursor->id_mask = length == 5 ? NMEA_ARCHIVE_ID_MASK : NMEA_ARCHIVE_TYPE_MASK;
+        cursor->type_bit = nmea_archive_type_bit(cursor->id);
+    }
+
+    // First block that can hold begin_key: max_key is running maximum, so it is sorted
+    size_t low = 0;
+    size_t high = reader->entry_count;
+    while(low < high) {
+        const size_t middle = low + (high - low) / 2;
+        if(reader->entries[middle].max_key < begin_key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    cursor->entry = low;
+    cursor->offset = low < reader->entry_count ? reader->entries[low].offset : reader->data.size;
+    return NMEA_SUCCESS;
+}
+
+int nmea_archive_next(nmea_archive_cursor* cursor, const nmea_archive_record** record) {
+    if(cursor == NULL || record == NULL) {
+        return NMEA_ASSERTION_FAILED;
+    }
+
+    *record = NULL;
+
+    const nmea_archive_reader* reader = cursor->reader;
+    const size_t size = reader->data.size;
+    while(cursor->offset < size) {
+        while(cursor->entry + 1 < reader->entry_count && cursor->offset >= reader->entries[cursor->entry + 1].offset) {
+            ++cursor->entry;
+        }
+        if(cursor->entry < reader->entry_count && cursor->offset == reader->entries[cursor->entry].offset) { // Block begin: decide from index entry
+            const nmea_archive_index_entry* entry = &reader->entries[cursor->entry];
+            if(entry->min_key > cursor->end_key) { // Keys are non-decreasing, so nothing in range follows
+                cursor->offset = size;
+                break;
+            }
+            if((entry->types & cursor->type_bit) == 0) {
+                cursor->offset = cursor->entry + 1 < reader->entry_count ? reader->entries[cursor->entry + 1].offset : size;
+                continue;
+            }
+        }
+
+        const uint8_t* data = (const uint8_t*)reader->data.data + cursor->offset;
+        uint32_t record_length;
+        uint32_t id;
+        uint64_t time_key;
+        uint16_t value_count;
+        if(size - cursor->offset < NMEA_ARCHIVE_RECORD_HEADER_SIZE) {
+            return NMEA_ARCHIVE_FORMAT_INCORRECT;
+        }
+        memcpy(&record_length, data, 4);
+        if(record_length < NMEA_ARCHIVE_RECORD_HEADER_SIZE || record_length % 4 != 0 || record_length > size - cursor->offset) {
+            return NMEA_ARCHIVE_FORMAT_INCORRECT;
+        }
+        cursor->offset += record_length;
+
+        memcpy(&id, data + 4, 4);
+        memcpy(&time_key, data + 8, 8);
+        if(time_key < cursor->begin_key || time_key > cursor->end_key || ((id ^ cursor->id) & cursor->id_mask) != 0) {
+            continue;
+        }
+        memcpy(&value_count, data + 16, 2);
+
+        nmea_archive_record* output = &cursor->record;
+        output->time_key = time_key;
+        output->start_delimiter = (char)data[18];
+        output->talker_id[0] = nmea_archive_unpack_char(id, 24);
+        output->talker_id[1] = nmea_archive_unpack_char(id, 18);
+        output->talker_id[2] = '\0';
+        output->type_code[0] = nmea_archive_unpack_char(id, 12);
+        output->type_code[1] = nmea_archive_unpack_char(id, 6);
+        output->type_code[2] = nmea_archive_unpack_char(id, 0);
+        output->type_code[3] = '\0';
+        output->value_count = value_count;
+        output->values = data + NMEA_ARCHIVE_RECORD_HEADER_SIZE;
+        output->values_length = record_length - NMEA_ARCHIVE_RECORD_HEADER_SIZE; // Including padding
+        *record = output;
+        return NMEA_SUCCESS;
+    }
+    return NMEA_SUCCESS;
+}
+
+int nmea_archive_record_to_message(const nmea_archive_record* record, const nmea_allocator* allocator, nmea_message** message) {
+    if(record == NULL || message == NULL) {
+        return NMEA_ASSERTION_FAILED;
+    }
+
+    if((*message = nmea_init_message_with_allocator(allocator)) == NULL) {
+        return NMEA_ALLOCATION_ERROR;
+    }
+    (*message)->start_delimiter = record->start_delimiter;
+    memcpy((*message)->talker_id, record->talker_id, sizeof(record->talker_id));
+    memcpy((*message)->type_code, record->type_code, sizeof(record->type_code));
+
+    const uint8_t* value = record->values;
+    const uint8_t* values_end = record->values + record->values_length;
+    for(size_t i = 0; i < record->value_count; ++i) {
+        int return_value = NMEA_ARCHIVE_FORMAT_INCORRECT;
+        if(value >= values_end || *value > values_end - value - 1
+            || (return_value = nmea_add_value(*message, (const char*)value + 1, *value)) != NMEA_SUCCESS) {
+            nmea_destroy_message(message);
+            return return_value;
+        }
+        value += 1 + *value;
+    }
+    return NMEA_SUCCESS;
+}
@@ -0,0 +1,109 @@
+#ifndef NMEA_ARCHIVE_H_
+#define NMEA_ARCHIVE_H_
+
+#include "nmea_mapped_file.h"
+
+#include <stdio.h>
+
+/// Binary archive of parsed messages with sparse time / type index (needs full build, not NMEA_MINIMUM_BUILD)
+/// Data file: 16 byte header ("NMEAARC1", byte order mark, reserved) followed by records (host byte order, 4 byte aligned):
+///   uint32 record length (including header and padding), uint32 packed sentence ID, uint64 time key,
+///   uint16 value count, uint8 start delimiter, uint8 reserved, then values as uint8 length + characters
+/// Index file: 16 byte header ("NMEAIDX1", byte order mark, interval) followed by one nmea_archive_index_entry per block of NMEA_ARCHIVE_INDEX_INTERVAL records
+/// Values are stored verbatim, so sentences regenerated by nmea_message_to_string equal archived ones (checksum is recomputed)
+
+#define NMEA_ARCHIVE_INDEX_INTERVAL 256 // Records per index block
+#define NMEA_ARCHIVE_HEADER_SIZE 16 // Data and index file header size
+#define NMEA_ARCHIVE_RECORD_HEADER_SIZE 20
+#define NMEA_ARCHIVE_MAX_VALUE_LENGTH 255
+
+/// Time key is milliseconds since 1970-01-01 UTC taken from GGA, RMC, GLL, GNS, GST or ZDA time; Date comes from last RMC / ZDA (time of day only until first date)
+/// Sentences without time get key of last timed sentence; Keys are expected to be non-decreasing (receiver log order)
+
+typedef struct {
+    uint64_t offset; // Data file offset of first record of block
+    uint64_t min_key; // Smallest time key in block
+    uint64_t max_key; // Largest time key of this and all previous blocks (non-decreasing over index)
+    uint64_t types; // Bit per hashed type code of records in block
+} nmea_archive_index_entry;
+
+typedef struct {
+    FILE* data;
+    FILE* index;
+    uint64_t offset; // Data file size
+    uint64_t time_key; // Key of last timed sentence
+    uint32_t time_ms; // Last UTC time (milliseconds since midnight); NMEA_TIME_INVALID before first timed sentence
+    uint32_t date; // Last UTC date (days since 1970-01-01); NMEA_DATE_INVALID before first RMC / ZDA
+    size_t block_records; // Records in current index block
+    nmea_archive_index_entry block; // Current index block
+} nmea_archive_writer;
+
+typedef struct {
+    nmea_mapped_file data;
+    nmea_mapped_file index;
+    const nmea_archive_index_entry* entries; // Index entries in mapped index file
+    size_t entry_count;
+} nmea_archive_reader;
+
+typedef struct {
+    uint64_t time_key; // Milliseconds since 1970-01-01 UTC
+    char start_delimiter; // "$" or "!"
+    char talker_id[3]; // 2 + NUL
+    char type_code[4]; // 3 + NUL
+    size_t value_count; // Number of values
+    const uint8_t* values; // Values (uint8 length + characters) in mapped data file
+    size_t values_length; // Size of values in bytes
+} nmea_archive_record;
+
+typedef struct {
+    const nmea_archive_reader* reader;
+    size_t entry; // Index block containing offset
+    uint64_t offset; // Data file offset of next record
+    uint64_t begin_key; // First time key of range
+    uint64_t end_key; // Last time key of range (inclusive)
+    uint32_t id; // Packed sentence ID to match
+    uint32_t id_mask; // Packed ID bits compared; 0 matches any sentence
+    uint64_t type_bit; // Index block type bit to match; All bits for any sentence
+    nmea_archive_record record; // Last returned record
+} nmea_archive_cursor;
+
+/// Function to create archive (existing data and index files are truncated)
+
+int nmea_archive_open_writer(nmea_archive_writer* writer, const char* data_path, const char* index_path);
+
+/// Function to append parsed (or user) message; Standard sentence IDs only (talker ID + type code), values longer than NMEA_ARCHIVE_MAX_VALUE_LENGTH are rejected
+
+int nmea_archive_append(nmea_archive_writer* writer, const nmea_message* message);
+
+/// Function to write last index block and close files
+
+int nmea_archive_close_writer(nmea_archive_writer* writer);
+
+/// Function to memory map archive and its index
+
+int nmea_archive_open_reader(nmea_archive_reader* reader, const char* data_path, const char* index_path);
+
+/// Function to unmap archive
+
+int nmea_archive_close_reader(nmea_archive_reader* reader);
+
+/// Function to position cursor on first record of time range by index probe (binary search over index blocks)
+
+int nmea_archive_seek(const nmea_archive_reader* reader // Open archive
+    , nmea_archive_cursor* cursor // Output
+    , const uint64_t begin_key // First time key of range
+    , const uint64_t end_key // Last time key of range (inclusive)
+    , const char* id); // Type code ("RMC") or talker ID + type code ("GPRMC") to match; NULL for all sentences
+
+/// Function to scan to next matching record; record is set to NULL at end of range (valid while reader is open otherwise)
+/// Index blocks without matching type or starting after end of range are skipped without reading their records
+
+int nmea_archive_next(nmea_archive_cursor* cursor, const nmea_archive_record** record);
+
+/// Function to regenerate message from record (then nmea_message_to_string gives archived sentence text)
+
+int nmea_archive_record_to_message(const nmea_archive_record* record
+    , const nmea_allocator* allocator // Allocator of message; NULL for malloc / free
+    , nmea_message** message); // Output; Destroy with nmea_destroy_message
+
+#endif
\ No newline at end of file
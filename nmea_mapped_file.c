@@ -0,0 +1,92 @@
+#if !defined _WIN32 && !defined _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L // mmap, posix_madvise
+#endif
+
+#include "nmea_mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+int nmea_map_file(const char* path, nmea_mapped_file* mapped) {
+    mapped->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    mapped->mapping = NULL;
+    mapped->data = NULL;
+    mapped->size = 0;
+    if(mapped->file == INVALID_HANDLE_VALUE) {
+        return NMEA_FILE_ERROR;
+    }
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(mapped->file, &size)) {
+        CloseHandle(mapped->file);
+        return NMEA_FILE_ERROR;
+    }
+    mapped->size = (size_t)size.QuadPart;
+    if(mapped->size == 0) { // Empty file cannot be mapped
+        return NMEA_SUCCESS;
+    }
+
+    if((mapped->mapping = CreateFileMappingA(mapped->file, NULL, PAGE_READONLY, 0, 0, NULL)) == NULL
+        || (mapped->data = (const char*)MapViewOfFile(mapped->mapping, FILE_MAP_READ, 0, 0, 0)) == NULL) {
+        if(mapped->mapping != NULL) {
+            CloseHandle(mapped->mapping);
+        }
+        CloseHandle(mapped->file);
+        return NMEA_FILE_ERROR;
+    }
+    return NMEA_SUCCESS;
+}
+
+void nmea_unmap_file(nmea_mapped_file* mapped) {
+    if(mapped->data != NULL) {
+        UnmapViewOfFile(mapped->data);
+        CloseHandle(mapped->mapping);
+    }
+    CloseHandle(mapped->file);
+}
+
+#else
+
+int nmea_map_file(const char* path, nmea_mapped_file* mapped) {
+    mapped->data = NULL;
+    mapped->size = 0;
+    if((mapped->file = open(path, O_RDONLY)) < 0) {
+        return NMEA_FILE_ERROR;
+    }
+
+    struct stat file_stat;
+    if(fstat(mapped->file, &file_stat) != 0) {
+        close(mapped->file);
+        return NMEA_FILE_ERROR;
+    }
+    mapped->size = (size_t)file_stat.st_size;
+    if(mapped->size == 0) { // Empty file cannot be mapped
+        return NMEA_SUCCESS;
+    }
+
+    void* data = mmap(NULL, mapped->size, PROT_READ, MAP_PRIVATE, mapped->file, 0);
+    if(data == MAP_FAILED) {
+        close(mapped->file);
+        return NMEA_FILE_ERROR;
+    }
+    posix_madvise(data, mapped->size, POSIX_MADV_SEQUENTIAL);
+    mapped->data = (const char*)data;
+    return NMEA_SUCCESS;
+}
+
+void nmea_unmap_file(nmea_mapped_file* mapped) {
+    if(mapped->data != NULL) {
+        munmap((void*)mapped->data, mapped->size);
+    }
+    close(mapped->file);
+}
+
+#endif
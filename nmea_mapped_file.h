@@ -0,0 +1,24 @@
+#ifndef NMEA_MAPPED_FILE_H_
+#define NMEA_MAPPED_FILE_H_
+
+#include "nmea_parser.h"
+
+/// Internal read-only file mapping shared by parallel parser and archive reader (mmap, or Win32 file mapping)
+/// Empty file is not mapped (data is NULL)
+
+typedef struct {
+#ifdef _WIN32
+    void* file; // HANDLE
+    void* mapping; // HANDLE
+#else
+    int file;
+#endif
+    const char* data;
+    size_t size;
+} nmea_mapped_file;
+
+int nmea_map_file(const char* path, nmea_mapped_file* mapped);
+
+void nmea_unmap_file(nmea_mapped_file* mapped);
+
+#endif
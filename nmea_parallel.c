@@ -0,0 +1,232 @@
+#include "nmea_parallel.h"
+#include "nmea_mapped_file.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+// Platform layer
+
+#ifdef _WIN32
+
+typedef HANDLE nmea_thread;
+typedef CRITICAL_SECTION nmea_mutex;
+typedef CONDITION_VARIABLE nmea_condition;
+
+#define nmea_mutex_init(mutex) InitializeCriticalSection(mutex)
+#define nmea_mutex_destroy(mutex) DeleteCriticalSection(mutex)
+#define nmea_mutex_lock(mutex) EnterCriticalSection(mutex)
+#define nmea_mutex_unlock(mutex) LeaveCriticalSection(mutex)
+#define nmea_condition_init(condition) InitializeConditionVariable(condition)
+#define nmea_condition_destroy(condition)
+#define nmea_condition_wait(condition, mutex) SleepConditionVariableCS(condition, mutex, INFINITE)
+#define nmea_condition_broadcast(condition) WakeAllConditionVariable(condition)
+
+#else
+
+typedef pthread_t nmea_thread;
+typedef pthread_mutex_t nmea_mutex;
+typedef pthread_cond_t nmea_condition;
+
+#define nmea_mutex_init(mutex) pthread_mutex_init(mutex, NULL)
+#define nmea_mutex_destroy(mutex) pthread_mutex_destroy(mutex)
+#define nmea_mutex_lock(mutex) pthread_mutex_lock(mutex)
+#define nmea_mutex_unlock(mutex) pthread_mutex_unlock(mutex)
+#define nmea_condition_init(condition) pthread_cond_init(condition, NULL)
+#define nmea_condition_destroy(condition) pthread_cond_destroy(condition)
+#define nmea_condition_wait(condition, mutex) pthread_cond_wait(condition, mutex)
+#define nmea_condition_broadcast(condition) pthread_cond_broadcast(condition)
+
+#endif
+
+// Chunk splitting
+
+size_t nmea_next_chunk_begin(const char* data, const size_t size, size_t offset) { // Next "$" or "!" following line terminator at or after offset
+    while(offset < size && data[offset] != '\r' && data[offset] != '\n') {
+        ++offset;
+    }
+    while(offset < size && data[offset] != '$' && data[offset] != '!') {
+        ++offset;
+    }
+    return offset;
+}
+
+// Worker pool
+
+typedef struct {
+    const char* data; // Mapped file
+    const size_t* chunk_begins; // chunk_count + 1 offsets
+    size_t chunk_count;
+    int strict;
+    int ordered;
+    nmea_parallel_sink sink;
+    void* user_data;
+
+    nmea_mutex mutex;
+    nmea_condition delivered_condition; // Signaled when next_delivered changes (ordered mode)
+    size_t next_chunk; // Next chunk to parse
+    size_t next_delivered; // Next chunk to deliver (ordered mode)
+    int return_value; // First error of any worker
+} nmea_parallel_context;
+
+#ifdef _WIN32
+DWORD WINAPI nmea_parallel_worker(LPVOID argument) {
+#else
+void* nmea_parallel_worker(void* argument) {
+#endif
+    nmea_parallel_context* context = (nmea_parallel_context*)argument;
+
+    nmea_batch batch; // Arena is reused for all chunks of this worker
+    nmea_init_batch(&batch);
+
+    for(;;) {
+        nmea_mutex_lock(&context->mutex);
+        const size_t chunk = context->next_chunk < context->chunk_count ? context->next_chunk++ : context->chunk_count;
+        nmea_mutex_unlock(&context->mutex);
+        if(chunk == context->chunk_count) {
+            break;
+        }
+
+        const size_t chunk_offset = context->chunk_begins[chunk];
+        const char* chunk_data = context->data + chunk_offset;
+        const int return_value = nmea_parse_batch(chunk_data, context->chunk_begins[chunk + 1] - chunk_offset, &batch, context->strict);
+
+        if(context->ordered == 0) {
+            if(return_value == NMEA_SUCCESS) {
+                context->sink(&batch, chunk_data, chunk_offset, context->user_data);
+            }
+        } else {
+            nmea_mutex_lock(&context->mutex);
+            while(context->next_delivered != chunk) {
+                nmea_condition_wait(&context->delivered_condition, &context->mutex);
+            }
+            nmea_mutex_unlock(&context->mutex);
+
+            if(return_value == NMEA_SUCCESS) { // Only this worker can deliver now
+                context->sink(&batch, chunk_data, chunk_offset, context->user_data);
+            }
+
+            nmea_mutex_lock(&context->mutex);
+            ++context->next_delivered;
+            nmea_condition_broadcast(&context->delivered_condition);
+            nmea_mutex_unlock(&context->mutex);
+        }
+
+        if(return_value != NMEA_SUCCESS) {
+            nmea_mutex_lock(&context->mutex);
+            if(context->return_value == NMEA_SUCCESS) {
+                context->return_value = return_value;
+            }
+            nmea_mutex_unlock(&context->mutex);
+        }
+    }
+
+    nmea_destroy_batch(&batch);
+    return 0;
+}
+
+int nmea_parse_file_parallel(const char* path
+    , const size_t thread_count
+    , const int strict
+    , const int ordered
+    , nmea_parallel_sink sink
+    , void* user_data) {
+    if(path == NULL || sink == NULL) {
+        return NMEA_ASSERTION_FAILED;
+    }
+
+    nmea_mapped_file mapped;
+    int return_value = nmea_map_file(path, &mapped);
+    if(return_value != NMEA_SUCCESS) {
+        return return_value;
+    }
+
+    if(mapped.size == 0) {
+        nmea_unmap_file(&mapped);
+        return NMEA_SUCCESS;
+    }
+
+    const size_t worker_count = thread_count == 0 ? 1 : thread_count;
+    size_t chunk_count = mapped.size / NMEA_PARALLEL_CHUNK_SIZE + 1;
+    if(chunk_count < worker_count) {
+        chunk_count = worker_count;
+    }
+
+    size_t* chunk_begins = (size_t*)malloc((chunk_count + 1) * sizeof(size_t));
+    nmea_thread* threads = (nmea_thread*)malloc(worker_count * sizeof(nmea_thread));
+    if(chunk_begins == NULL || threads == NULL) {
+        free(chunk_begins);
+        free(threads);
+        nmea_unmap_file(&mapped);
+        return NMEA_ALLOCATION_ERROR;
+    }
+
+    // Split points are moved forward to message begins; Chunks that collapse to nothing are dropped
+    const size_t target_chunk_size = mapped.size / chunk_count;
+    size_t count = 0;
+    chunk_begins[0] = 0;
+    for(size_t i = 1; i < chunk_count; ++i) {
+        const size_t begin = nmea_next_chunk_begin(mapped.data, mapped.size, i * target_chunk_size);
+        if(begin > chunk_begins[count] && begin < mapped.size) {
+            chunk_begins[++count] = begin;
+        }
+    }
+    chunk_begins[++count] = mapped.size;
+
+    nmea_parallel_context context;
+    context.data = mapped.data;
+    context.chunk_begins = chunk_begins;
+    context.chunk_count = count;
+    context.strict = strict;
+    context.ordered = ordered;
+    context.sink = sink;
+    context.user_data = user_data;
+    context.next_chunk = 0;
+    context.next_delivered = 0;
+    context.return_value = NMEA_SUCCESS;
+    nmea_mutex_init(&context.mutex);
+    nmea_condition_init(&context.delivered_condition);
+
+    size_t started = 0;
+    for(; started < worker_count; ++started) {
+#ifdef _WIN32
+        if((threads[started] = CreateThread(NULL, 0, nmea_parallel_worker, &context, 0, NULL)) == NULL) {
+            break;
+        }
+#else
+        if(pthread_create(&threads[started], NULL, nmea_parallel_worker, &context) != 0) {
+            break;
+        }
+#endif
+    }
+
+    if(started == 0) {
+        return_value = NMEA_THREAD_ERROR;
+    }
+
+    // Started workers take over all chunks, so partial start only costs parallelism
+    for(size_t i = 0; i < started; ++i) {
+#ifdef _WIN32
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+    }
+
+    if(return_value == NMEA_SUCCESS) {
+        return_value = context.return_value;
+    }
+
+    nmea_condition_destroy(&context.delivered_condition);
+    nmea_mutex_destroy(&context.mutex);
+    free(threads);
+    free(chunk_begins);
+    nmea_unmap_file(&mapped);
+    return return_value;
+}
\ No newline at end of file
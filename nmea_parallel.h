@@ -0,0 +1,30 @@
+#ifndef NMEA_PARALLEL_H_
+#define NMEA_PARALLEL_H_
+
+#include "nmea_parser.h"
+
+/// Parallel log file parser (POSIX threads + mmap, or Win32 threads + file mapping)
+
+/// Sink is called once per chunk; batch field / message offsets are relative to chunk
+/// Ordered sink calls are serialized and follow file order; Unordered sink is called concurrently from worker threads
+
+typedef void(*nmea_parallel_sink)(const nmea_batch* batch // Messages of chunk
+    , const char* chunk // Chunk begin in mapped file (valid during the call only)
+    , const size_t chunk_offset // Chunk offset in file
+    , void* user_data);
+
+/// Function to parse whole file on pool of worker threads
+/// File is split into chunks, each chunk boundary is moved to next "$" following line terminator
+
+int nmea_parse_file_parallel(const char* path // Input file
+    , const size_t thread_count // Number of worker threads (0 = 1)
+    , const int strict // Strictly comply the standard
+    , const int ordered // Non-zero to deliver chunks to sink in file order
+    , nmea_parallel_sink sink // Called for every chunk
+    , void* user_data); // Passed to sink; Can be NULL
+
+/// Target size of one chunk (bytes)
+
+#define NMEA_PARALLEL_CHUNK_SIZE (1 << 20)
+
+#endif
\ No newline at end of file
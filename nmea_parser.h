@@ -2,6 +2,94 @@
 #define NMEA_H_
 
 #include <stddef.h>
+#include <stdint.h>
+
+/// Maximum length of NMEA message string (including <CRLF> 
+
+#define NMEA_MESSAGE_MAX_LENGTH 82
+
+/// Field view capacity sufficient for any message not longer than NMEA_MESSAGE_MAX_LENGTH
+
+#define NMEA_MESSAGE_MAX_FIELDS NMEA_MESSAGE_MAX_LENGTH
+
+/// Maximum length of vendor sentence ID ("P" + manufacturer mnemonic + optional sentence type, e.g. PUBX, PGRMZ, PMTK314)
+
+#define NMEA_VENDOR_ID_MAX_LENGTH 8
+
+typedef struct {
+    void*(*allocate)(void* context, const size_t size); // Returns NULL on failure
+    void(*deallocate)(void* context, void* ptr); // Can be NULL if memory is released only by reset (arena)
+    void* context; // Passed to allocate / deallocate
+} nmea_allocator;
+
+typedef struct {
+    char* buffer; // Caller owned memory
+    size_t capacity; // Usable buffer size
+    size_t used; // Bump pointer offset
+} nmea_arena;
+
+typedef struct {
+    char* buffer; // Caller owned memory
+    size_t block_size; // Size of every block (aligned)
+    size_t block_count; // Number of blocks in buffer
+    size_t next_unused; // Index of first never allocated block
+    void* free_list; // Released blocks
+} nmea_pool;
+
+/// Sentence filter applied right after talker ID + type code is read; Talkers and types are matched independently
+/// (sentence is listed if its type is listed and either the type was added without talker or its talker is listed)
+
+#define NMEA_FILTER_ALLOW 0 // Only listed sentences are parsed
+#define NMEA_FILTER_DENY 1 // Listed sentences are skipped
+#define NMEA_FILTER_TALKER_COUNT (26 * 26)
+#define NMEA_FILTER_TYPE_COUNT (26 * 26 * 26)
+
+typedef struct {
+    int mode; // NMEA_FILTER_ALLOW or NMEA_FILTER_DENY
+    uint8_t talkers[(NMEA_FILTER_TALKER_COUNT + 7) / 8]; // Bit per talker ID (AA - ZZ)
+    uint8_t types[(NMEA_FILTER_TYPE_COUNT + 7) / 8]; // Bit per type code (AAA - ZZZ)
+    uint8_t any_talker_types[(NMEA_FILTER_TYPE_COUNT + 7) / 8]; // Bit per type code added without talker ID
+} nmea_filter;
+
+/// Parser statistics (counted only if library is built with NMEA_STATS; phase cycles also need NMEA_STATS_CYCLES on x86)
+/// Counters are written by parsing thread only; Snapshot / reset can be called from one other (monitoring) thread meanwhile
+/// Only nmea_parser_parse_message counts (stream, batch, field view, dispatch and parallel parsers have no parser context)
+
+#define NMEA_STATS_SENTENCE_TYPES 64 // Distinct sentence IDs counted separately
+#define NMEA_STATS_ERROR_CODES 34 // Counters indexed by -error code; Has to be 1 - NMEA_LAST_ERROR (checked when library is compiled)
+#define NMEA_STATS_MAX_FIELDS 32 // Fields per sentence histogram size
+#define NMEA_STATS_PHASE_FRAMING 0 // Delimiter scan (checksum excluded)
+#define NMEA_STATS_PHASE_CHECKSUM 1 // Checksum reduction
+#define NMEA_STATS_PHASE_SPLITTING 2 // Field splitting and message creation
+#define NMEA_STATS_PHASES 3
+
+typedef struct {
+    uint64_t key; // Sentence ID packed one character per byte (see nmea_registry_entry); 0 if unused
+    uint64_t count; // Number of sentences with this ID
+} nmea_stats_sentence;
+
+typedef struct {
+    uint64_t sentences; // Sentences found (begin delimiter seen)
+    uint64_t parsed; // Sentences parsed successfully
+    uint64_t bytes; // Bytes consumed (sum of message_end_index)
+    uint64_t skipped_bytes; // Bytes skipped while searching for "$" or "!"
+    uint64_t errors[NMEA_STATS_ERROR_CODES]; // Indexed by -error code; errors[0] counts codes out of range
+    nmea_stats_sentence sentence_types[NMEA_STATS_SENTENCE_TYPES]; // Sentences per talker ID + type code (or vendor ID), failed and filtered ones included once ID was scanned
+    uint64_t other_sentence_types; // Framed sentences not fitting sentence_types
+    uint64_t field_counts[NMEA_STATS_MAX_FIELDS + 1]; // Parsed sentences per number of fields (last counter: NMEA_STATS_MAX_FIELDS or more)
+    uint64_t cycles[NMEA_STATS_PHASES]; // Time stamp counter cycles per NMEA_STATS_PHASE_*
+} nmea_stats_counters;
+
+typedef struct {
+    nmea_stats_counters counters; // Written by parsing thread
+    nmea_stats_counters baseline; // Counters at last reset (written by monitoring thread)
+} nmea_stats;
+
+typedef struct {
+    const nmea_allocator* allocator; // Allocator of parsed messages; NULL for malloc / free
+    const nmea_filter* filter; // Sentence filter; NULL to parse all sentences
+    nmea_stats* stats; // Statistics block; NULL to disable counting
+} nmea_parser;
 
 typedef struct nmea_value nmea_value;
 
@@ -12,25 +100,453 @@ struct nmea_value {
 };
 
 typedef struct {
+    char start_delimiter; // "$" (parametric sentence) or "!" (encapsulated sentence, e.g. AIVDM)
     char talker_id[3]; // 2 + NUL
     char type_code[4]; // 3 + NUL
     size_t value_count; // Number of values in message
     nmea_value* first_value; // Pointer to first value in message
     nmea_value* last_value; // Pointer to last value in message for value add optimization
+    const nmea_allocator* allocator; // Allocator of message, its values and value strings; NULL for malloc / free
 } nmea_message;
 
+typedef struct {
+    size_t offset; // Field begin offset in parsed input string
+    size_t length; // Field length
+} nmea_field;
+
+typedef struct {
+    const char* str; // Parsed input string (fields point back into it)
+    char start_delimiter; // "$" or "!"; NUL if message was not parsed
+    char talker_id[3]; // 2 + NUL
+    char type_code[4]; // 3 + NUL
+    size_t field_count; // Number of fields in message
+    size_t field_capacity; // Capacity of fields array
+    nmea_field* fields; // Caller owned array of field slices
+} nmea_field_view;
+
+/// Sentence handler registered in dispatch registry; Return value is passed through by nmea_dispatch_message
+
+typedef int(*nmea_sentence_handler)(const nmea_field_view* view, void* user_data);
+
+/// Dispatch registry hash table size (power of two); At most 3/4 of entries can be used
+
+#define NMEA_REGISTRY_CAPACITY 64
+
+typedef struct {
+    uint64_t key; // Sentence ID packed one character per byte; 0 if entry is free
+    nmea_sentence_handler handler; // Called for matching sentences
+    void* user_data; // Passed to handler
+} nmea_registry_entry;
+
+typedef struct {
+    nmea_registry_entry entries[NMEA_REGISTRY_CAPACITY];
+    size_t entry_count; // Number of registered handlers
+} nmea_registry;
+
+typedef struct {
+    int state; // Scanner state
+    int strict; // Strictly comply the standard
+    int checksum; // Running checksum of message
+    size_t checksum_digit_count; // Number of characters after "*"
+    size_t length; // Number of message characters scanned so far (including "$" or "!")
+    size_t id_delimiter_index; // Index of first ","; 0 if not found yet
+    size_t checksum_delimiter_index; // Index of "*"; 0 if not found yet
+    size_t field_begin_index; // Index of current field begin
+    int buffered; // Non-zero if message began in previous chunk and is kept in buffer
+    char buffer[NMEA_MESSAGE_MAX_LENGTH + 2]; // "$" or "!" + message + end delimiter
+    nmea_field fields[NMEA_MESSAGE_MAX_FIELDS]; // Field slices of current message
+    nmea_field_view view; // View passed to stream handler
+} nmea_stream;
+
+/// Stream handler is called once per complete (or abandoned) message; view (and view->str) is valid during the call only
+/// view->str points to "$" or "!" and message_length includes end delimiter; On error view has no fields
+/// Abandoned message (cut off by next "$" / "!" (NMEA_MESSAGE_TRUNCATED) or NUL, or longer than NMEA_MESSAGE_MAX_LENGTH) is reported with message_length of characters scanned before it was abandoned
+
+typedef void(*nmea_stream_handler)(const nmea_field_view* view, const size_t message_length, const int status, void* user_data);
+
+typedef struct {
+    size_t message_count; // Number of messages in batch
+    size_t field_count; // Number of fields of all messages in batch
+    size_t message_capacity; // Arena capacity (messages)
+    size_t field_capacity; // Arena capacity (fields)
+    nmea_field* fields; // Field slices of all messages (offsets relative to input buffer)
+    size_t* message_offsets; // Offset of "$" or "!" in input buffer
+    size_t* message_lengths; // Message length including end delimiter; Abandoned message: characters up to the point it was abandoned
+    size_t* first_fields; // Index of first field of message in fields
+    size_t* field_counts; // Number of fields of message
+    int* statuses; // NMEA_SUCCESS or error code of message
+    char* talker_ids; // 2 characters per message (not NUL terminated)
+    char* type_codes; // 3 characters per message (not NUL terminated)
+    void* arena; // Single allocation behind all columns (reused between batches)
+} nmea_batch;
+
+/// Typed sentence decoders output
+/// Empty fields decode to NAN (floating point), 0 (integer), '\0' (character), NMEA_TIME_INVALID or NMEA_DATE_INVALID
+
+#define NMEA_TIME_INVALID 0xFFFFFFFFu
+#define NMEA_DATE_INVALID 0xFFFFFFFFu
+
+typedef struct {
+    uint32_t time_ms; // UTC time (milliseconds since midnight)
+    double lat; // Latitude (degrees; negative for S)
+    double lon; // Longitude (degrees; negative for W)
+    uint8_t fix; // Fix quality
+    uint8_t sats; // Number of satellites in use
+    float hdop; // Horizontal dilution of precision
+    float alt; // Altitude above mean sea level (meters)
+    float geoid_separation; // Geoid separation (meters)
+} nmea_gga;
+
+typedef struct {
+    uint32_t time_ms; // UTC time (milliseconds since midnight)
+    char status; // A = valid, V = warning
+    double lat; // Latitude (degrees; negative for S)
+    double lon; // Longitude (degrees; negative for W)
+    float speed_knots; // Speed over ground
+    float course; // Course over ground (degrees true)
+    uint32_t date; // UTC date (days since 1970-01-01)
+    float magnetic_variation; // Degrees; negative for W
+    char mode; // Mode indicator (NMEA 2.3+)
+} nmea_rmc;
+
+typedef struct {
+    char mode; // M = manual, A = automatic
+    uint8_t fix_type; // 1 = no fix, 2 = 2D, 3 = 3D
+    uint16_t satellite_ids[12]; // Satellites used for fix; 0 for empty slot
+    float pdop; // Position dilution of precision
+    float hdop; // Horizontal dilution of precision
+    float vdop; // Vertical dilution of precision
+} nmea_gsa;
+
+typedef struct {
+    uint16_t prn; // Satellite ID
+    uint8_t elevation; // Degrees
+    uint16_t azimuth; // Degrees true
+    uint8_t snr; // dB-Hz; 0 if not tracked
+} nmea_gsv_satellite;
+
+typedef struct {
+    uint8_t message_count; // Number of GSV messages in cycle
+    uint8_t message_number; // Number of this message (1 based)
+    uint8_t sats_in_view; // Satellites in view
+    uint8_t satellite_count; // Satellite records in this message (0 - 4)
+    nmea_gsv_satellite satellites[4];
+} nmea_gsv;
+
+typedef struct {
+    float course_true; // Degrees true
+    float course_magnetic; // Degrees magnetic
+    float speed_knots; // Speed over ground (knots)
+    float speed_kmh; // Speed over ground (km/h)
+    char mode; // Mode indicator (NMEA 2.3+)
+} nmea_vtg;
+
+typedef struct {
+    double lat; // Latitude (degrees; negative for S)
+    double lon; // Longitude (degrees; negative for W)
+    uint32_t time_ms; // UTC time (milliseconds since midnight)
+    char status; // A = valid, V = invalid
+    char mode; // Mode indicator (NMEA 2.3+)
+} nmea_gll;
+
+#define NMEA_DECODED_NONE 0
+#define NMEA_DECODED_GGA 1
+#define NMEA_DECODED_RMC 2
+#define NMEA_DECODED_GSA 3
+#define NMEA_DECODED_GSV 4
+#define NMEA_DECODED_VTG 5
+#define NMEA_DECODED_GLL 6
+
+typedef struct {
+    int type; // NMEA_DECODED_*
+    union {
+        nmea_gga gga;
+        nmea_rmc rmc;
+        nmea_gsa gsa;
+        nmea_gsv gsv;
+        nmea_vtg vtg;
+        nmea_gll gll;
+    } data;
+} nmea_decoded;
+
+/// Epoch assembler merges decoded sentences of one receiver epoch (same UTC time) into single fix record
+
+#define NMEA_EPOCH_GGA 0x01
+#define NMEA_EPOCH_RMC 0x02
+#define NMEA_EPOCH_GSA 0x04
+#define NMEA_EPOCH_GSV 0x08 // Complete GSV cycle (all parts in sequence)
+#define NMEA_EPOCH_VTG 0x10
+#define NMEA_EPOCH_GLL 0x20
+#define NMEA_EPOCH_MAX_SATELLITES 32
+
+typedef struct {
+    unsigned sentences; // NMEA_EPOCH_* mask of merged sentences
+    uint32_t time_ms; // UTC time (milliseconds since midnight); NMEA_TIME_INVALID if epoch has no GGA, RMC or GLL
+    uint32_t date; // UTC date (days since 1970-01-01); NMEA_DATE_INVALID if epoch has no RMC
+    double lat; // Latitude (degrees; negative for S); NAN if unknown
+    double lon; // Longitude (degrees; negative for W); NAN if unknown
+    float alt; // Altitude above mean sea level (meters)
+    float geoid_separation; // Geoid separation (meters)
+    float speed_knots; // Speed over ground
+    float course; // Course over ground (degrees true)
+    float pdop; // Position dilution of precision
+    float hdop; // Horizontal dilution of precision
+    float vdop; // Vertical dilution of precision
+    char status; // RMC / GLL status (A = valid, V = warning)
+    char mode; // Mode indicator (NMEA 2.3+)
+    uint8_t fix_quality; // GGA fix quality
+    uint8_t fix_type; // GSA fix type (1 = no fix, 2 = 2D, 3 = 3D)
+    uint8_t sats_used; // GGA number of satellites in use
+    uint8_t used_count; // Number of used_ids
+    uint16_t used_ids[NMEA_EPOCH_MAX_SATELLITES]; // Satellites used for fix (all GSA messages of epoch)
+    uint8_t sats_in_view; // GSV satellites in view
+    uint8_t satellite_count; // Number of satellites
+    nmea_gsv_satellite satellites[NMEA_EPOCH_MAX_SATELLITES]; // Satellites in view table
+} nmea_epoch_fix;
+
+typedef struct {
+    unsigned expected; // NMEA_EPOCH_* mask of sentences completing epoch
+    int pending; // Non-zero if current epoch is complete but not reported yet
+    uint8_t next_gsv; // Number of next expected GSV message; 0 outside GSV cycle
+    nmea_epoch_fix current; // Epoch being assembled
+    nmea_epoch_fix completed; // Last reported epoch
+} nmea_epoch_assembler;
+
+/// AIS (AIVDM / AIVDO) payload bits; Longest AIS message occupies 5 slots (1008 bits)
+
+#define NMEA_AIS_MAX_PAYLOAD_BITS 1008
+
+typedef struct {
+    uint8_t bits[NMEA_AIS_MAX_PAYLOAD_BITS / 8 + 1]; // First payload bit is most significant bit of bits[0]
+    size_t bit_count; // Number of payload bits (fill bits excluded)
+    char channel; // Radio channel (A, B, 1 or 2); NUL if not given
+} nmea_ais_payload;
+
+typedef struct {
+    nmea_ais_payload payload; // Fragments received so far
+    uint8_t fragment_count; // Number of fragments of message; 0 if slot is free
+    uint8_t next_fragment; // Number of next expected fragment (1 based)
+} nmea_ais_slot;
+
+/// Multi-fragment messages are reassembled per sequential message ID (0 - 9) and channel (A / B); Last slot holds single fragment messages
+
+#define NMEA_AIS_ASSEMBLER_SLOTS 21
+
+typedef struct {
+    nmea_ais_slot slots[NMEA_AIS_ASSEMBLER_SLOTS];
+} nmea_ais_assembler;
+
 /// Function to parse NMEA string
+/// message_end_index is set on errors as well, so parsing can always continue at str + message_end_index:
+/// past end delimiter of malformed message, at next "$" or "!" if message was cut off (NMEA_MESSAGE_TRUNCATED),
+/// at begin delimiter if message is not terminated yet (NMEA_MESSAGE_END_DELIMITER_NOT_FOUND; 0 means more data is needed)
+/// or at terminating NUL if no message begins (NMEA_MESSAGE_BEGIN_DELIMITER_NOT_FOUND)
 
 int nmea_parse_message(const char* str // Input string
+    , nmea_message** message // Output
+    , size_t* message_end_index // Message end index (Next message begin index)
+    , const int strict // Strictly comply the standard
+    , int(*vendor_ext_msg_handler)(const char* str, size_t* message_end_index, const int strict)); // Non-standard (vendor ext message) message handler; Can be NULL (message is not created for vendor messages)
+
+/// Function to initialize parser context (malloc / free allocator)
+
+int nmea_init_parser(nmea_parser* parser);
+
+/// Function to set allocator used for messages parsed by parser context; Allocator must outlive the messages
+
+int nmea_parser_set_allocator(nmea_parser* parser, const nmea_allocator* allocator); // allocator can be NULL (malloc / free)
+
+/// Function to set sentence filter of parser context; Filter must outlive its use by parser
+/// Filtered out sentences are only framed (message_end_index is set) and NMEA_MESSAGE_FILTERED is returned
+
+int nmea_parser_set_filter(nmea_parser* parser, const nmea_filter* filter); // filter can be NULL (parse all sentences)
+
+/// Function to set statistics block of parser context (counted by nmea_parser_parse_message); Returns NMEA_STATS_DISABLED if library is built without NMEA_STATS
+
+int nmea_parser_set_stats(nmea_parser* parser, nmea_stats* stats); // stats can be NULL (no counting)
+
+/// Function to initialize statistics block (all counters zero)
+
+int nmea_init_stats(nmea_stats* stats);
+
+/// Function to read counters accumulated since last reset; Safe while parsing thread updates them
+
+int nmea_stats_snapshot(const nmea_stats* stats, nmea_stats_counters* snapshot);
+
+/// Function to restart counting (parsing thread is not blocked); Safe while parsing thread updates counters
+
+int nmea_stats_reset(nmea_stats* stats);
+
+/// Function to initialize (empty) sentence filter
+
+int nmea_init_filter(nmea_filter* filter, const int mode); // NMEA_FILTER_ALLOW or NMEA_FILTER_DENY
+
+/// Function to add sentence to filter: type code for any talker (e.g. "RMC") or talker ID + type code (e.g. "GPRMC")
+
+int nmea_filter_add(nmea_filter* filter, const char* id);
+
+/// Function to parse NMEA string using parser context
+
+int nmea_parser_parse_message(const nmea_parser* parser // Parser context
+    , const char* str // Input string
     , nmea_message** message // Output
     , size_t* message_end_index // Message end index (Next message begin index)
     , const int strict // Strictly comply the standard
     , int(*vendor_ext_msg_handler)(const char* str, size_t* message_end_index, const int strict)); // Non-standard (vendor ext message) message handler; Can be NULL
 
+/// Function to initialize bump arena over caller owned buffer; All allocations are released at once by nmea_reset_arena
+
+int nmea_init_arena(nmea_arena* arena, void* buffer, const size_t capacity);
+
+/// Function to release all arena allocations (O(1))
+
+int nmea_reset_arena(nmea_arena* arena);
+
+/// Function to create allocator backed by arena
+
+int nmea_init_arena_allocator(nmea_allocator* allocator, nmea_arena* arena);
+
+/// Function to initialize fixed-size block pool over caller owned buffer
+/// block_size has to fit nmea_message, nmea_value and longest value string + 1 (NMEA_MESSAGE_MAX_LENGTH + 1 covers any standard message)
+
+int nmea_init_pool(nmea_pool* pool, void* buffer, const size_t buffer_size, const size_t block_size);
+
+/// Function to release all pool blocks (O(1))
+
+int nmea_reset_pool(nmea_pool* pool);
+
+/// Function to create allocator backed by pool
+
+int nmea_init_pool_allocator(nmea_allocator* allocator, nmea_pool* pool);
+
+/// Function to initialize field view over caller owned fields array
+
+int nmea_init_field_view(nmea_field_view* view, nmea_field* fields, const size_t field_capacity);
+
+/// Function to parse NMEA string in place (no heap use); Fields stay valid as long as input string does
+/// Vendor sentence ID (4 - NMEA_VENDOR_ID_MAX_LENGTH characters) is split into talker_id (2 characters) and type_code (at most 3 following characters)
+
+int nmea_parse_field_view(const char* str // Input string
+    , nmea_field_view* view // Output
+    , size_t* message_end_index // Message end index (Next message begin index)
+    , const int strict); // Strictly comply the standard
+
+/// Function to access field of field view; Returns NULL if index is out of range
+
+const char* nmea_field_at(const nmea_field_view* view, const size_t index, size_t* field_length); // field_length can be NULL
+
+/// Function to find next sentence begin ("$" or "!") in buffer (not NUL terminated; NUL and binary bytes are skipped); Returns length if there is none
+/// Use to skip embedded NUL (nmea_parse_message stops at NUL) or garbage between messages
+
+size_t nmea_resync(const char* buffer, const size_t length);
+
+/// Function to initialize (empty) dispatch registry
+
+int nmea_init_registry(nmea_registry* registry);
+
+/// Function to register handler for sentence ID (talker ID + type code, e.g. "GPGGA", or vendor ID, e.g. "PUBX"); Replaces handler registered for the same ID
+/// Returns NMEA_MESSAGE_ID_LENGTH_INCORRECT for malformed ID or NMEA_REGISTRY_FULL
+
+int nmea_registry_add(nmea_registry* registry, const char* id, nmea_sentence_handler handler, void* user_data);
+
+/// Function to parse NMEA string into field view (see nmea_parse_field_view) and call handler registered for its sentence ID (single hash table probe, no heap use)
+/// Returns handler return value, NMEA_UNHANDLED_VENDOR_EXT_MESSAGE or NMEA_UNSUPPORTED_MESSAGE if no handler is registered, or parse error
+
+int nmea_dispatch_message(const nmea_registry* registry // Dispatch registry
+    , const char* str // Input string
+    , nmea_field_view* view // Field view passed to handler
+    , size_t* message_end_index // Message end index (Next message begin index)
+    , const int strict); // Strictly comply the standard
+
+/// Function to decode GGA, RMC, GSA, GSV, VTG or GLL message (any talker) into typed struct; Returns NMEA_UNSUPPORTED_MESSAGE for other types
+
+int nmea_decode(const nmea_field_view* view, nmea_decoded* decoded);
+
+/// Functions to convert field (pointer + length, no NUL needed) to number; Locale independent
+/// Return NMEA_NUMBER_EMPTY, NMEA_NUMBER_INVALID_CHARACTER, NMEA_NUMBER_FORMAT_INCORRECT, NMEA_NUMBER_OUT_OF_RANGE or NMEA_HEMISPHERE_INCORRECT on error
+
+int nmea_field_to_fixed(const char* str, const size_t length, int64_t* mantissa, int* decimals); // [+-]digits[.digits] -> mantissa * 10^-decimals (up to 18 digits)
+int nmea_field_to_uint(const char* str, const size_t length, uint32_t* value); // digits
+int nmea_field_to_double(const char* str, const size_t length, double* value); // [+-]digits[.digits]
+int nmea_field_to_time_ms(const char* str, const size_t length, uint32_t* time_ms); // hhmmss[.sss] -> milliseconds since midnight
+int nmea_field_to_days(const char* str, const size_t length, uint32_t* days); // ddmmyy -> days since 1970-01-01 (yy < 80 is 20yy)
+int nmea_field_to_degrees(const char* str, const size_t length, const char hemisphere, double* degrees); // (d)ddmm.mmmm + N/S/E/W (or NUL) -> signed degrees
+int nmea_field_to_microdegrees(const char* str, const size_t length, const char hemisphere, int32_t* microdegrees); // (d)ddmm.mmmm + N/S/E/W (or NUL) -> signed degrees * 10^6 (rounded)
+
+/// Function to initialize (or reset) epoch assembler (no allocation)
+
+int nmea_init_epoch_assembler(nmea_epoch_assembler* assembler, const unsigned expected); // expected: NMEA_EPOCH_* mask, e.g. NMEA_EPOCH_GGA | NMEA_EPOCH_RMC | NMEA_EPOCH_GSA | NMEA_EPOCH_GSV
+
+/// Function to merge decoded sentence into current epoch
+/// fix is set (valid until next call) when epoch completes (all expected sentences merged) or when sentence with other UTC time starts next epoch; Otherwise it is set to NULL
+/// Epoch completed by the same sentence that started it while previous epoch was reported is reported by next call (or nmea_epoch_flush)
+
+int nmea_epoch_add(nmea_epoch_assembler* assembler, const nmea_decoded* decoded, const nmea_epoch_fix** fix);
+
+/// Function to report incomplete epoch (e.g. when receiver stops sending); fix is set to NULL if no sentence was merged since last report
+
+int nmea_epoch_flush(nmea_epoch_assembler* assembler, const nmea_epoch_fix** fix);
+
+/// Function to unpack 6-bit ASCII armored AIS payload (pointer + length, no NUL needed) into payload bits; Returns NMEA_AIS_PAYLOAD_INCORRECT on invalid character or overflow
+
+int nmea_ais_unarmor(const char* str, const size_t length, const unsigned fill_bits, nmea_ais_payload* payload);
+
+/// Functions to read unsigned / two's complement signed field of width 1 - 32 bits starting at bit offset start; Return NMEA_AIS_PAYLOAD_INCORRECT if field exceeds payload
+
+int nmea_ais_get_uint(const nmea_ais_payload* payload, const size_t start, const size_t width, uint32_t* value);
+int nmea_ais_get_int(const nmea_ais_payload* payload, const size_t start, const size_t width, int32_t* value);
+
+/// Function to read 6-bit text field of char_count characters; output has to hold char_count + 1 characters (NUL terminated, "@" padding kept)
+
+int nmea_ais_get_text(const nmea_ais_payload* payload, const size_t start, const size_t char_count, char* output);
+
+/// Function to initialize (or reset) AIS fragment reassembly table (no allocation)
+
+int nmea_init_ais_assembler(nmea_ais_assembler* assembler);
+
+/// Function to add VDM / VDO fragment (field view of parsed message) to reassembly table
+/// payload is set to completed message (valid until next fragment with same sequential message ID and channel is added) or to NULL while fragments are missing
+/// Fragment out of order discards partially assembled message and returns NMEA_AIS_FRAGMENT_INCORRECT
+
+int nmea_ais_add_fragment(nmea_ais_assembler* assembler, const nmea_field_view* view, const nmea_ais_payload** payload);
+
+/// Function to initialize (or reset) streaming parser context
+
+int nmea_init_stream(nmea_stream* stream, const int strict);
+
+/// Function to feed arbitrary chunk of bytes (not NUL terminated) to streaming parser
+/// Messages split between chunks are carried in the context; Messages longer than NMEA_MESSAGE_MAX_LENGTH are rejected even if not strict
+
+int nmea_stream_feed(nmea_stream* stream // Stream context
+    , const char* bytes // Input chunk
+    , const size_t length // Input chunk length
+    , nmea_stream_handler handler // Called for every message
+    , void* user_data); // Passed to handler; Can be NULL
+
+/// Function to initialize batch (no allocation until first parse)
+
+int nmea_init_batch(nmea_batch* batch);
+
+/// Function to parse all messages in buffer (not NUL terminated) into batch columns; Previous batch content is discarded
+/// Messages longer than NMEA_MESSAGE_MAX_LENGTH are rejected even if not strict (see nmea_stream_feed)
+
+int nmea_parse_batch(const char* buffer // Input buffer
+    , const size_t length // Input buffer length
+    , nmea_batch* batch // Output
+    , const int strict); // Strictly comply the standard
+
+/// Function to release batch arena
+
+int nmea_destroy_batch(nmea_batch* batch);
+
 /// Function to create user message
 
 nmea_message* nmea_init_message();
 
+/// Function to create user message using allocator
+
+nmea_message* nmea_init_message_with_allocator(const nmea_allocator* allocator); // allocator can be NULL (malloc / free)
+
 /// Function to destroy user message
 
 int nmea_destroy_message(nmea_message** message);
@@ -43,6 +559,20 @@ int nmea_add_value(nmea_message* message, const char* str_value, const size_t st
 
 int nmea_message_to_string(const nmea_message* message, char** message_str);
 
+/// Function to write message (including <CRLF>, without NUL) into caller buffer in single pass; Returns NMEA_BUFFER_TOO_SMALL if message does not fit
+
+int nmea_message_write(const nmea_message* message, char* buffer, const size_t capacity, size_t* written);
+
+/// Function to write message into ring buffer starting at write_index (wraps at ring_capacity); At most free_space characters are written
+
+int nmea_message_write_ring(const nmea_message* message, char* ring, const size_t ring_capacity, const size_t write_index, const size_t free_space, size_t* written);
+
+/// Function to pack consecutive messages into one buffer for single write call
+/// Stops at first message that does not fit (messages_written tells where to continue); Fails only if not even first message fits
+/// Used instead of writev / iovec scatter list: packed buffer needs one write call on every platform (no struct iovec on Win32, no IOV_MAX limit)
+
+int nmea_messages_write(const nmea_message* const* messages, const size_t message_count, char* buffer, const size_t capacity, size_t* written, size_t* messages_written);
+
 /// Function to destroy user message string
 
 int nmea_destroy_message_string(char** message_str);
@@ -64,9 +594,25 @@ int nmea_destroy_message_string(char** message_str);
 #define NMEA_UNHANDLED_VENDOR_EXT_MESSAGE -12
 #define NMEA_UNKNOWN_ERROR -13
 #define NMEA_ASSERTION_FAILED -14
-
-/// Maximum length of NMEA message string (including <CRLF> 
-
-#define NMEA_MESSAGE_MAX_LENGTH 82
+#define NMEA_FIELD_VIEW_CAPACITY_EXCEEDED -15
+#define NMEA_FIELD_COUNT_INCORRECT -16
+#define NMEA_FIELD_VALUE_INCORRECT -17
+#define NMEA_NUMBER_EMPTY -18
+#define NMEA_NUMBER_INVALID_CHARACTER -19
+#define NMEA_NUMBER_FORMAT_INCORRECT -20
+#define NMEA_NUMBER_OUT_OF_RANGE -21
+#define NMEA_HEMISPHERE_INCORRECT -22
+#define NMEA_FILE_ERROR -23
+#define NMEA_THREAD_ERROR -24
+#define NMEA_BUFFER_TOO_SMALL -25
+#define NMEA_AIS_FRAGMENT_INCORRECT -26
+#define NMEA_AIS_PAYLOAD_INCORRECT -27
+#define NMEA_REGISTRY_FULL -28
+#define NMEA_MESSAGE_FILTERED -29
+#define NMEA_STATS_DISABLED -30
+#define NMEA_MESSAGE_TRUNCATED -31
+#define NMEA_EPOCH_SEQUENCE_INCORRECT -32
+#define NMEA_ARCHIVE_FORMAT_INCORRECT -33
+#define NMEA_LAST_ERROR NMEA_ARCHIVE_FORMAT_INCORRECT // Lowest return value; Update when adding return value
 
 #endif
\ No newline at end of file
@@ -1,6 +1,1334 @@
+#if !defined _WIN32 && !defined _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L // mmap, mprotect, sysconf
+#endif
+
 #include "nmea_parser.h"
+#include "nmea_archive.h"
+#include "nmea_parallel.h"
 
+#include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static int failures = 0;
+
+#define TEST_CHECK(condition) do { \
+    if(!(condition)) { \
+        printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #condition); \
+        ++failures; \
+    } \
+} while(0)
+
+// Scanning kernels are internal to nmea_parser.c; Declared here to compare vector kernels with scalar ones
+
+typedef struct {
+    const char* (*find_delimiter)(const char* str);
+    const char* (*find_begin)(const char* str);
+    const char* (*find_line_end)(const char* str);
+    const char* (*find_begin_n)(const char* begin, const char* end);
+    int (*checksum)(const char* begin, const char* end);
+} test_scan_kernel;
+
+const char* nmea_find_delimiter_scalar(const char* str);
+const char* nmea_find_begin_scalar(const char* str);
+const char* nmea_find_line_end_scalar(const char* str);
+const char* nmea_find_begin_n_scalar(const char* begin, const char* end);
+int nmea_checksum_scalar(const char* begin, const char* end);
+
+#if !defined NMEA_NO_SIMD && (defined __x86_64__ || defined _M_X64) // Same condition as NMEA_SIMD_X86 in nmea_parser.c
+const char* nmea_find_delimiter_sse2(const char* str);
+const char* nmea_find_begin_sse2(const char* str);
+const char* nmea_find_line_end_sse2(const char* str);
+const char* nmea_find_begin_n_sse2(const char* begin, const char* end);
+int nmea_checksum_sse2(const char* begin, const char* end);
+const char* nmea_find_delimiter_avx2(const char* str);
+const char* nmea_find_begin_avx2(const char* str);
+const char* nmea_find_line_end_avx2(const char* str);
+const char* nmea_find_begin_n_avx2(const char* begin, const char* end);
+int nmea_checksum_avx2(const char* begin, const char* end);
+const char* nmea_find_delimiter_dispatch(const char* str);
+const char* nmea_find_begin_dispatch(const char* str);
+const char* nmea_find_line_end_dispatch(const char* str);
+const char* nmea_find_begin_n_dispatch(const char* begin, const char* end);
+int nmea_checksum_dispatch(const char* begin, const char* end);
+int nmea_cpu_supports_avx2();
+
+static const test_scan_kernel testScanKernels[] = {
+    { nmea_find_delimiter_dispatch, nmea_find_begin_dispatch, nmea_find_line_end_dispatch, nmea_find_begin_n_dispatch, nmea_checksum_dispatch },
+    { nmea_find_delimiter_sse2, nmea_find_begin_sse2, nmea_find_line_end_sse2, nmea_find_begin_n_sse2, nmea_checksum_sse2 },
+    { nmea_find_delimiter_avx2, nmea_find_begin_avx2, nmea_find_line_end_avx2, nmea_find_begin_n_avx2, nmea_checksum_avx2 } // Last: skipped without AVX2
+};
+#define TEST_SCAN_KERNEL_COUNT (nmea_cpu_supports_avx2() ? 3u : 2u)
+#else
+static const test_scan_kernel testScanKernels[] = {
+    { nmea_find_delimiter_scalar, nmea_find_begin_scalar, nmea_find_line_end_scalar, nmea_find_begin_n_scalar, nmea_checksum_scalar }
+};
+#define TEST_SCAN_KERNEL_COUNT 1u
+#endif
+
+size_t test_scan_mismatches(const char* str, const char* end) { // Kernels disagreeing with scalar kernel; str is NUL terminated, [str, end) is scanned by find_begin_n and checksum
+    size_t mismatches = 0;
+    for(size_t i = 0; i < TEST_SCAN_KERNEL_COUNT; ++i) {
+        const test_scan_kernel* kernel = &testScanKernels[i];
+        mismatches += kernel->find_delimiter(str) != nmea_find_delimiter_scalar(str);
+        mismatches += kernel->find_begin(str) != nmea_find_begin_scalar(str);
+        mismatches += kernel->find_line_end(str) != nmea_find_line_end_scalar(str);
+        mismatches += kernel->find_begin_n(str, end) != nmea_find_begin_n_scalar(str, end);
+        mismatches += kernel->checksum(str, end) != nmea_checksum_scalar(str, end);
+    }
+    return mismatches;
+}
+
+void test_scan_fill(char* str, const size_t length) { // Text without any delimiter (high bytes included), NUL terminated
+    static const char filler[] = "A1.\xB5\x7F \xFF\x80";
+    for(size_t i = 0; i < length; ++i) {
+        str[i] = filler[i % (sizeof(filler) - 1)];
+    }
+    str[length] = '\0';
+}
+
+void test_scan() {
+    static const char delimiters[] = ",*\r\n$!"; // NUL is tested through sizeof (terminator included)
+    static char storage[256];
+    char* base = storage + ((32 - ((uintptr_t)storage & 31)) & 31); // 32 byte aligned
+    const size_t length = 96;
+
+    // Every start misalignment against every delimiter at every position (last lane of 16 and 32 byte blocks included)
+    for(size_t misalignment = 0; misalignment < 32; ++misalignment) {
+        char* str = base + misalignment;
+        test_scan_fill(str, length);
+        TEST_CHECK(test_scan_mismatches(str, str + length) == 0);
+        for(size_t d = 0; d < sizeof(delimiters); ++d) {
+            for(size_t position = 0; position < 64; ++position) {
+                test_scan_fill(str, length);
+                str[position] = delimiters[d];
+                TEST_CHECK(test_scan_mismatches(str, str + position + 1) == 0);
+                TEST_CHECK(test_scan_mismatches(str, str + length) == 0);
+            }
+        }
+        test_scan_fill(str, length);
+        str[31 - misalignment] = ','; // Last lane of first 32 byte block
+        TEST_CHECK(testScanKernels[TEST_SCAN_KERNEL_COUNT - 1].find_delimiter(str) == str + 31 - misalignment);
+        TEST_CHECK(testScanKernels[TEST_SCAN_KERNEL_COUNT - 1].find_begin(str) == str + length);
+
+        // Embedded NUL ends NUL terminated scans, but not find_begin_n and checksum
+        for(size_t position = 0; position + 5 < length; ++position) {
+            test_scan_fill(str, length);
+            str[position] = '\0';
+            str[position + 5] = '$';
+            TEST_CHECK(test_scan_mismatches(str, str + length) == 0);
+            TEST_CHECK(testScanKernels[0].find_begin_n(str, str + length) == str + position + 5);
+            TEST_CHECK(testScanKernels[0].find_begin(str) == str + position);
+        }
+    }
+
+    // Strings ending right before inaccessible page: aligned block loads must never cross page boundary
+#ifdef _WIN32
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    const size_t pageSize = systemInfo.dwPageSize;
+    char* pages = (char*)VirtualAlloc(NULL, 2 * pageSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    DWORD oldProtection;
+    const int guarded = pages != NULL && VirtualProtect(pages + pageSize, pageSize, PAGE_NOACCESS, &oldProtection);
+#else
+    const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    const int zero = open("/dev/zero", O_RDONLY);
+    char* pages = zero < 0 ? NULL : (char*)mmap(NULL, 2 * pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, zero, 0);
+    if(pages == (char*)MAP_FAILED) {
+        pages = NULL;
+    }
+    if(zero >= 0) {
+        close(zero);
+    }
+    const int guarded = pages != NULL && mprotect(pages + pageSize, pageSize, PROT_NONE) == 0;
+#endif
+    TEST_CHECK(guarded);
+    if(guarded) {
+        char* pageEnd = pages + pageSize;
+        test_scan_fill(pageEnd - 64, 63); // NUL in last byte of page
+        for(size_t offset = 1; offset <= 64; ++offset) {
+            TEST_CHECK(test_scan_mismatches(pageEnd - offset, pageEnd) == 0);
+            TEST_CHECK(testScanKernels[TEST_SCAN_KERNEL_COUNT - 1].find_delimiter(pageEnd - offset) == pageEnd - 1);
+        }
+        pageEnd[-2] = '!';
+        for(size_t offset = 2; offset <= 64; ++offset) {
+            TEST_CHECK(test_scan_mismatches(pageEnd - offset, pageEnd) == 0);
+        }
+    }
+    if(pages != NULL) {
+#ifdef _WIN32
+        VirtualFree(pages, 0, MEM_RELEASE);
+#else
+        munmap(pages, 2 * pageSize);
+#endif
+    }
+}
+
+void test_converters() {
+    int64_t mantissa;
+    int decimals;
+    TEST_CHECK(nmea_field_to_fixed("-12.340", 7, &mantissa, &decimals) == NMEA_SUCCESS && mantissa == -12340 && decimals == 3);
+    TEST_CHECK(nmea_field_to_fixed("", 0, &mantissa, &decimals) == NMEA_NUMBER_EMPTY);
+    TEST_CHECK(nmea_field_to_fixed("1.2.3", 5, &mantissa, &decimals) == NMEA_NUMBER_INVALID_CHARACTER);
+    TEST_CHECK(nmea_field_to_fixed("1234567890123456789", 19, &mantissa, &decimals) == NMEA_NUMBER_OUT_OF_RANGE);
+
+    uint32_t value;
+    TEST_CHECK(nmea_field_to_uint("4294967295", 10, &value) == NMEA_SUCCESS && value == 4294967295u);
+    TEST_CHECK(nmea_field_to_uint("4294967296", 10, &value) == NMEA_NUMBER_OUT_OF_RANGE);
+    TEST_CHECK(nmea_field_to_uint("12a", 3, &value) == NMEA_NUMBER_INVALID_CHARACTER);
+
+    double number;
+    TEST_CHECK(nmea_field_to_double("61.7", 4, &number) == NMEA_SUCCESS && number > 61.69 && number < 61.71);
+
+    uint32_t timeMs;
+    TEST_CHECK(nmea_field_to_time_ms("092750.123", 10, &timeMs) == NMEA_SUCCESS && timeMs == 34070123u);
+    TEST_CHECK(nmea_field_to_time_ms("235960", 6, &timeMs) == NMEA_SUCCESS && timeMs == 86400000u); // Leap second
+    TEST_CHECK(nmea_field_to_time_ms("246000", 6, &timeMs) == NMEA_NUMBER_OUT_OF_RANGE);
+    TEST_CHECK(nmea_field_to_time_ms("0927.5", 6, &timeMs) == NMEA_NUMBER_INVALID_CHARACTER);
+
+    uint32_t days;
+    TEST_CHECK(nmea_field_to_days("280511", 6, &days) == NMEA_SUCCESS && days == 15122u);
+    TEST_CHECK(nmea_field_to_days("010170", 6, &days) == NMEA_SUCCESS && days == 36525u); // 2070-01-01
+    TEST_CHECK(nmea_field_to_days("001299", 6, &days) == NMEA_NUMBER_OUT_OF_RANGE);
+    TEST_CHECK(nmea_field_to_days("310226", 6, &days) == NMEA_NUMBER_OUT_OF_RANGE); // 31 February
+    TEST_CHECK(nmea_field_to_days("290223", 6, &days) == NMEA_NUMBER_OUT_OF_RANGE); // 2023 is not leap year
+    TEST_CHECK(nmea_field_to_days("290224", 6, &days) == NMEA_SUCCESS && days == 19782u); // 2024-02-29
+    TEST_CHECK(nmea_field_to_days("290200", 6, &days) == NMEA_SUCCESS && days == 11016u); // 2000 is leap year (divisible by 400)
+    TEST_CHECK(nmea_field_to_days("310411", 6, &days) == NMEA_NUMBER_OUT_OF_RANGE); // 31 April
+    TEST_CHECK(nmea_field_to_days("311211", 6, &days) == NMEA_SUCCESS && days == 15339u);
+
+    double degrees;
+    TEST_CHECK(nmea_field_to_degrees("5321.6802", 9, 'N', &degrees) == NMEA_SUCCESS && degrees > 53.361336 && degrees < 53.361337);
+    TEST_CHECK(nmea_field_to_degrees("00630.3372", 10, 'W', &degrees) == NMEA_SUCCESS && degrees < -6.50561 && degrees > -6.50563);
+    TEST_CHECK(nmea_field_to_degrees("5360.0000", 9, 'N', &degrees) == NMEA_NUMBER_OUT_OF_RANGE);
+    TEST_CHECK(nmea_field_to_degrees("5321.6802", 9, 'X', &degrees) == NMEA_HEMISPHERE_INCORRECT);
+
+    int32_t microdegrees;
+    TEST_CHECK(nmea_field_to_microdegrees("5321.6802", 9, 'N', &microdegrees) == NMEA_SUCCESS && microdegrees == 53361337);
+    TEST_CHECK(nmea_field_to_microdegrees("00630.3372", 10, 'W', &microdegrees) == NMEA_SUCCESS && microdegrees == -6505620);
+    TEST_CHECK(nmea_field_to_microdegrees("17959.99999", 11, 'E', &microdegrees) == NMEA_SUCCESS && microdegrees == 180000000);
+
+    // Long fractions (up to 12 decimals) must not overflow the rounding arithmetic
+    TEST_CHECK(nmea_field_to_microdegrees("4859.999999999999", 17, 'N', &microdegrees) == NMEA_SUCCESS && microdegrees == 49000000);
+    TEST_CHECK(nmea_field_to_microdegrees("4800.000029999999", 17, 'S', &microdegrees) == NMEA_SUCCESS && microdegrees == -48000000);
+    TEST_CHECK(nmea_field_to_microdegrees("4800.000030000000", 17, 'N', &microdegrees) == NMEA_SUCCESS && microdegrees == 48000001);
+    TEST_CHECK(nmea_field_to_microdegrees("17959.999999999999", 18, 'W', &microdegrees) == NMEA_SUCCESS && microdegrees == -180000000);
+    TEST_CHECK(nmea_field_to_microdegrees("4859.9999999999999", 18, 'N', &microdegrees) == NMEA_NUMBER_FORMAT_INCORRECT); // More than 12 decimals
+}
+
+typedef struct {
+    size_t messageCount;
+    int lastStatus;
+    size_t lastLength;
+    size_t lastFieldCount;
+    char lastId[6];
+    char lastField[16];
+} test_stream_result;
+
+void test_stream_handler(const nmea_field_view* view, const size_t message_length, const int status, void* user_data) {
+    test_stream_result* result = (test_stream_result*)user_data;
+    ++result->messageCount;
+    result->lastStatus = status;
+    result->lastLength = message_length;
+    result->lastFieldCount = view->field_count;
+    memcpy(result->lastId, view->talker_id, 2);
+    memcpy(result->lastId + 2, view->type_code, 4);
+    result->lastField[0] = '\0';
+    if(view->field_count > 1) {
+        size_t length;
+        const char* field = nmea_field_at(view, 1, &length);
+        if(length < sizeof(result->lastField)) {
+            memcpy(result->lastField, field, length);
+            result->lastField[length] = '\0';
+        }
+    }
+}
+
+int test_stream_status(const char* str, const int strict) { // Status of single message fed to stream byte by byte
+    nmea_stream stream;
+    test_stream_result result;
+    memset(&result, 0, sizeof(result));
+    nmea_init_stream(&stream, strict);
+    for(size_t i = 0; str[i] != '\0'; ++i) {
+        nmea_stream_feed(&stream, str + i, 1, test_stream_handler, &result);
+    }
+    return result.messageCount == 1 ? result.lastStatus : NMEA_UNKNOWN_ERROR;
+}
+
+int test_buffer_status(const char* str, const int strict) {
+    nmea_field fields[NMEA_MESSAGE_MAX_FIELDS];
+    nmea_field_view view;
+    size_t messageEndIndex;
+    nmea_init_field_view(&view, fields, NMEA_MESSAGE_MAX_FIELDS);
+    return nmea_parse_field_view(str, &view, &messageEndIndex, strict);
+}
+
+void test_field_view() {
+    static const char gga[] = "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n";
+    nmea_field fields[NMEA_MESSAGE_MAX_FIELDS];
+    nmea_field_view view;
+    size_t messageEndIndex;
+    size_t length;
+
+    // Capacity: exact fit parses, one field short fails without partial fields, but message is still framed
+    TEST_CHECK(nmea_init_field_view(&view, fields, 14) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_parse_field_view(gga, &view, &messageEndIndex, 1) == NMEA_SUCCESS && view.field_count == 14);
+    TEST_CHECK(messageEndIndex == sizeof(gga) - 2); // "\n" is left for next call to skip
+    TEST_CHECK(nmea_init_field_view(&view, fields, 13) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_parse_field_view(gga, &view, &messageEndIndex, 1) == NMEA_FIELD_VIEW_CAPACITY_EXCEEDED);
+    TEST_CHECK(view.field_count == 0 && messageEndIndex == sizeof(gga) - 2);
+    TEST_CHECK(nmea_field_at(&view, 0, &length) == NULL && length == 0);
+    TEST_CHECK(nmea_init_field_view(&view, NULL, 0) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_parse_field_view(gga, &view, &messageEndIndex, 1) == NMEA_FIELD_VIEW_CAPACITY_EXCEEDED);
+
+    // More fields than NMEA_MESSAGE_MAX_FIELDS: too long in strict mode, over view capacity otherwise
+    char commas[6 + NMEA_MESSAGE_MAX_FIELDS + 1 + 3];
+    memcpy(commas, "$GPTXT", 6);
+    memset(commas + 6, ',', NMEA_MESSAGE_MAX_FIELDS + 1); // First comma ends ID, every comma adds field
+    memcpy(commas + 6 + NMEA_MESSAGE_MAX_FIELDS + 1, "\r\n", 3);
+    TEST_CHECK(nmea_init_field_view(&view, fields, NMEA_MESSAGE_MAX_FIELDS) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_parse_field_view(commas, &view, &messageEndIndex, 0) == NMEA_FIELD_VIEW_CAPACITY_EXCEEDED && view.field_count == 0);
+    TEST_CHECK(messageEndIndex == 6 + NMEA_MESSAGE_MAX_FIELDS + 2);
+    TEST_CHECK(nmea_parse_field_view(commas, &view, &messageEndIndex, 1) == NMEA_MESSAGE_LONGER_THAN_MAX_LENGTH && view.field_count == 0);
+    memcpy(commas + 6 + NMEA_MESSAGE_MAX_FIELDS, "\r\n", 3);
+    TEST_CHECK(nmea_parse_field_view(commas, &view, &messageEndIndex, 0) == NMEA_SUCCESS && view.field_count == NMEA_MESSAGE_MAX_FIELDS);
+    TEST_CHECK(nmea_field_at(&view, NMEA_MESSAGE_MAX_FIELDS - 1, &length) != NULL && length == 0);
+
+    // Empty fields (trailing ones included) are present with zero length, unlike fields out of range
+    TEST_CHECK(nmea_parse_field_view("$GPTXT,A,,,\r\n", &view, &messageEndIndex, 0) == NMEA_SUCCESS && view.field_count == 4);
+    TEST_CHECK(nmea_field_at(&view, 0, &length) != NULL && length == 1);
+    for(size_t i = 1; i < 4; ++i) {
+        length = 99;
+        TEST_CHECK(nmea_field_at(&view, i, &length) != NULL && length == 0);
+    }
+    TEST_CHECK(nmea_parse_field_view("$GPTXT,*63\r\n", &view, &messageEndIndex, 1) == NMEA_SUCCESS && view.field_count == 1);
+    TEST_CHECK(nmea_field_at(&view, 0, &length) != NULL && length == 0);
+    TEST_CHECK(nmea_parse_field_view("$GPGSV,3,3,11,29,09,301,24,16,09,020,,36,,,*76\r\n", &view, &messageEndIndex, 1) == NMEA_SUCCESS);
+    TEST_CHECK(view.field_count == 15 && view.fields[14].length == 0 && view.fields[13].length == 0);
+    TEST_CHECK(nmea_field_at(&view, 11, &length) != NULL && length == 2 && memcmp(nmea_field_at(&view, 11, NULL), "36", 2) == 0);
+
+    // Out of range access
+    length = 99;
+    TEST_CHECK(nmea_field_at(&view, 15, &length) == NULL && length == 0);
+    TEST_CHECK(nmea_field_at(&view, (size_t)-1, NULL) == NULL);
+    TEST_CHECK(nmea_field_at(NULL, 0, &length) == NULL);
+    TEST_CHECK(nmea_init_field_view(&view, fields, NMEA_MESSAGE_MAX_FIELDS) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_field_at(&view, 0, &length) == NULL && length == 0); // Nothing parsed yet
+    TEST_CHECK(nmea_parse_field_view("$GPGGA,1,2", &view, &messageEndIndex, 0) == NMEA_MESSAGE_END_DELIMITER_NOT_FOUND);
+    TEST_CHECK(nmea_field_at(&view, 0, &length) == NULL && length == 0); // Failed parse leaves no fields
+
+    // Vendor IDs: "P" + manufacturer + optional type, 4 to NMEA_VENDOR_ID_MAX_LENGTH characters split into talker ID and type code
+    static const struct {
+        const char* str;
+        int status;
+        const char* talkerId;
+        const char* typeCode;
+    } vendorCases[] = {
+        { "$PUBX,00,1\r\n", NMEA_SUCCESS, "PU", "BX" },
+        { "$PGRMZ,246,f,3\r\n", NMEA_SUCCESS, "PG", "RMZ" },
+        { "$PMTK314,0,1\r\n", NMEA_SUCCESS, "PM", "TK3" },
+        { "$PABCDEFG,1\r\n", NMEA_SUCCESS, "PA", "BCD" }, // NMEA_VENDOR_ID_MAX_LENGTH
+        { "$PABCDEFGH,1\r\n", NMEA_MESSAGE_ID_LENGTH_INCORRECT, "", "" },
+        { "$PGR,1\r\n", NMEA_MESSAGE_ID_LENGTH_INCORRECT, "", "" },
+        { "$GPGGAX,1\r\n", NMEA_MESSAGE_ID_LENGTH_INCORRECT, "", "" }, // Only vendor IDs may be longer
+        { "$GPGG,1\r\n", NMEA_MESSAGE_ID_LENGTH_INCORRECT, "", "" }
+    };
+    for(size_t i = 0; i < sizeof(vendorCases) / sizeof(vendorCases[0]); ++i) {
+        TEST_CHECK(nmea_parse_field_view(vendorCases[i].str, &view, &messageEndIndex, 0) == vendorCases[i].status);
+        TEST_CHECK(strcmp(view.talker_id, vendorCases[i].talkerId) == 0 && strcmp(view.type_code, vendorCases[i].typeCode) == 0);
+        TEST_CHECK(messageEndIndex == strlen(vendorCases[i].str) - 1);
+    }
+    TEST_CHECK(nmea_parse_field_view("$PMTK314,0,1\r\n", &view, &messageEndIndex, 0) == NMEA_SUCCESS && view.field_count == 2);
+    TEST_CHECK(nmea_field_at(&view, 1, &length) != NULL && length == 1 && *nmea_field_at(&view, 1, NULL) == '1');
+}
+
+void test_stream() {
+    static const char gga[] = "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n";
+
+    // Message split at every possible chunk boundary
+    for(size_t split = 0; split <= sizeof(gga) - 1; ++split) {
+        nmea_stream stream;
+        test_stream_result result;
+        memset(&result, 0, sizeof(result));
+        nmea_init_stream(&stream, 1);
+        nmea_stream_feed(&stream, gga, split, test_stream_handler, &result);
+        nmea_stream_feed(&stream, gga + split, sizeof(gga) - 1 - split, test_stream_handler, &result);
+        TEST_CHECK(result.messageCount == 1 && result.lastStatus == NMEA_SUCCESS && result.lastFieldCount == 14); // "\n" after "\r" is skipped
+    }
+
+    nmea_stream stream;
+    test_stream_result result;
+    memset(&result, 0, sizeof(result));
+    nmea_init_stream(&stream, 1);
+    nmea_stream_feed(&stream, "noise$GPGGA,0927", 16, test_stream_handler, &result);
+    TEST_CHECK(result.messageCount == 0);
+    nmea_stream_feed(&stream, "50.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\n", 61, test_stream_handler, &result);
+    TEST_CHECK(result.messageCount == 1 && result.lastStatus == NMEA_SUCCESS && result.lastFieldCount == 14);
+    TEST_CHECK(strcmp(result.lastId, "GPGGA") == 0 && strcmp(result.lastField, "5321.6802") == 0);
+    TEST_CHECK(result.lastLength == 71);
+
+    nmea_stream_feed(&stream, "$GPGGA,1*00$GPGSA", 17, test_stream_handler, &result); // Cut off by next message
+    TEST_CHECK(result.messageCount == 2 && result.lastStatus == NMEA_MESSAGE_TRUNCATED);
+
+    char overLength[120];
+    memset(overLength, 'A', sizeof(overLength));
+    memcpy(overLength, "$GPTXT,", 7);
+    nmea_init_stream(&stream, 0);
+    memset(&result, 0, sizeof(result));
+    nmea_stream_feed(&stream, overLength, sizeof(overLength), test_stream_handler, &result);
+    TEST_CHECK(result.messageCount == 1 && result.lastStatus == NMEA_MESSAGE_LONGER_THAN_MAX_LENGTH);
+
+    // Checksum tails: stream and buffer parsers agree
+    static const char* const tails[] = { "0A", "0a", "0A1", "0A1234567890ABCDEF0123", "0G", "G0", "0", "", "FF", "A0" };
+    for(size_t i = 0; i < sizeof(tails) / sizeof(tails[0]); ++i) {
+        char message[NMEA_MESSAGE_MAX_LENGTH + 1];
+        snprintf(message, sizeof(message), "$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*%s\r\n", tails[i]);
+        for(int strict = 0; strict <= 1; ++strict) {
+            const int bufferStatus = test_buffer_status(message, strict);
+            const int streamStatus = test_stream_status(message, strict);
+            if(bufferStatus != streamStatus) {
+                printf("checksum tail \"%s\" strict %d: buffer %d, stream %d\n", tails[i], strict, bufferStatus, streamStatus);
+            }
+            TEST_CHECK(bufferStatus == streamStatus);
+        }
+    }
+
+    // Sentence IDs: stream and buffer parsers apply the same length rule (vendor IDs are 4 - NMEA_VENDOR_ID_MAX_LENGTH characters)
+    static const char* const ids[] = { "PUBX", "PGRMZ", "PUBX00", "PABCDEFG", "PABCDEFGH", "PAB", "GPGG", "GPGGAX", "" };
+    for(size_t i = 0; i < sizeof(ids) / sizeof(ids[0]); ++i) {
+        char message[NMEA_MESSAGE_MAX_LENGTH + 1];
+        snprintf(message, sizeof(message), "$%s,00,1\r\n", ids[i]);
+        const int bufferStatus = test_buffer_status(message, 0);
+        const int streamStatus = test_stream_status(message, 0);
+        if(bufferStatus != streamStatus) {
+            printf("sentence ID \"%s\": buffer %d, stream %d\n", ids[i], bufferStatus, streamStatus);
+        }
+        TEST_CHECK(bufferStatus == streamStatus);
+    }
+    nmea_init_stream(&stream, 0);
+    memset(&result, 0, sizeof(result));
+    nmea_stream_feed(&stream, "$PUBX,00,123\r\n", 15, test_stream_handler, &result);
+    TEST_CHECK(result.messageCount == 1 && result.lastStatus == NMEA_SUCCESS && strcmp(result.lastId, "PUBX") == 0 && strcmp(result.lastField, "123") == 0);
+
+    TEST_CHECK(test_stream_status("$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*0A1\r\n", 0) == NMEA_CHECKSUM_ERROR); // Read like strtol: 0xA1
+    TEST_CHECK(test_stream_status("$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*0A1\r\n", 1) == NMEA_INCORRECT_CHECKSUM_LENGTH);
+}
+
+void test_checksum() {
+    // Checksum field is read like strtol(field, NULL, 16) was; Strict mode wants exactly two characters
+    static const struct {
+        const char* tail;
+        int status;
+        int strictStatus;
+    } cases[] = {
+        { "0A", NMEA_SUCCESS, NMEA_SUCCESS },
+        { "0a", NMEA_SUCCESS, NMEA_SUCCESS },
+        { "G1", NMEA_CHECKSUM_ERROR, NMEA_CHECKSUM_ERROR },
+        { "1", NMEA_CHECKSUM_ERROR, NMEA_INCORRECT_CHECKSUM_LENGTH },
+        { "1a", NMEA_CHECKSUM_ERROR, NMEA_CHECKSUM_ERROR },
+        { "123", NMEA_CHECKSUM_ERROR, NMEA_INCORRECT_CHECKSUM_LENGTH },
+        { "0A1", NMEA_CHECKSUM_ERROR, NMEA_INCORRECT_CHECKSUM_LENGTH },
+        { "00A", NMEA_SUCCESS, NMEA_INCORRECT_CHECKSUM_LENGTH },
+        { "0AZ", NMEA_SUCCESS, NMEA_INCORRECT_CHECKSUM_LENGTH }, // Trailing garbage ends value
+        { "A", NMEA_SUCCESS, NMEA_INCORRECT_CHECKSUM_LENGTH },
+        { "", NMEA_CHECKSUM_ERROR, NMEA_INCORRECT_CHECKSUM_LENGTH },
+        { " 0A", NMEA_SUCCESS, NMEA_INCORRECT_CHECKSUM_LENGTH },
+        { "0x0A", NMEA_SUCCESS, NMEA_INCORRECT_CHECKSUM_LENGTH },
+        { "-0A", NMEA_CHECKSUM_ERROR, NMEA_INCORRECT_CHECKSUM_LENGTH },
+        { "0A1234567890ABCDEF", NMEA_CHECKSUM_ERROR, NMEA_INCORRECT_CHECKSUM_LENGTH }
+    };
+    for(size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        char str[NMEA_MESSAGE_MAX_LENGTH + 1];
+        snprintf(str, sizeof(str), "$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*%s\r\n", cases[i].tail);
+        for(int strict = 0; strict <= 1; ++strict) {
+            const int expected = strict != 0 ? cases[i].strictStatus : cases[i].status;
+            nmea_message* message;
+            size_t messageEndIndex;
+            const int status = nmea_parse_message(str, &message, &messageEndIndex, strict, NULL);
+            if(status == NMEA_SUCCESS) {
+                nmea_destroy_message(&message);
+            }
+            if(status != expected) {
+                printf("checksum \"%s\" strict %d: %d, expected %d\n", cases[i].tail, strict, status, expected);
+            }
+            TEST_CHECK(status == expected);
+            TEST_CHECK(test_buffer_status(str, strict) == expected);
+            TEST_CHECK(test_stream_status(str, strict) == expected);
+        }
+    }
+}
+
+void test_batch() {
+    char buffer[512];
+    size_t length = 0;
+    static const char gga[] = "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n";
+    static const char cutOff[] = "$GPGSA,A,3,10"; // Next message begins before end delimiter
+    static const char rmc[] = "$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*43\r\n";
+    static const char tail[] = "$GPVTG,31.66"; // Unterminated at buffer end
+
+    memcpy(buffer + length, gga, sizeof(gga) - 1);
+    length += sizeof(gga) - 1;
+    const size_t overLengthOffset = length;
+    memcpy(buffer + length, "$GPTXT,", 7);
+    memset(buffer + length + 7, 'X', 100);
+    length += 107;
+    buffer[length++] = '\n';
+    const size_t cutOffOffset = length;
+    memcpy(buffer + length, cutOff, sizeof(cutOff) - 1);
+    length += sizeof(cutOff) - 1;
+    const size_t rmcOffset = length;
+    memcpy(buffer + length, rmc, sizeof(rmc) - 1);
+    length += sizeof(rmc) - 1;
+    const size_t tailOffset = length;
+    memcpy(buffer + length, tail, sizeof(tail) - 1);
+    length += sizeof(tail) - 1;
+
+    nmea_batch batch;
+    nmea_init_batch(&batch);
+    TEST_CHECK(nmea_parse_batch(buffer, length, &batch, 0) == NMEA_SUCCESS);
+    TEST_CHECK(batch.message_count == 5);
+    if(batch.message_count == 5) {
+        TEST_CHECK(batch.statuses[0] == NMEA_SUCCESS && batch.message_offsets[0] == 0 && batch.message_lengths[0] == sizeof(gga) - 2);
+        TEST_CHECK(batch.field_counts[0] == 14 && memcmp(batch.type_codes, "GGA", 3) == 0);
+        const nmea_field* latitude = &batch.fields[batch.first_fields[0] + 1];
+        TEST_CHECK(latitude->length == 9 && memcmp(buffer + latitude->offset, "5321.6802", 9) == 0);
+
+        // Abandoned messages keep their real position, so bad input can be located
+        TEST_CHECK(batch.statuses[1] == NMEA_MESSAGE_LONGER_THAN_MAX_LENGTH);
+        TEST_CHECK(batch.message_offsets[1] == overLengthOffset && batch.message_lengths[1] == NMEA_MESSAGE_MAX_LENGTH + 1);
+        TEST_CHECK(batch.field_counts[1] == 0);
+        TEST_CHECK(batch.statuses[2] == NMEA_MESSAGE_TRUNCATED);
+        TEST_CHECK(batch.message_offsets[2] == cutOffOffset && batch.message_lengths[2] == sizeof(cutOff) - 1);
+
+        TEST_CHECK(batch.statuses[3] == NMEA_SUCCESS && batch.message_offsets[3] == rmcOffset && batch.field_counts[3] == 12);
+        TEST_CHECK(memcmp(batch.talker_ids + 2 * 3, "GP", 2) == 0 && memcmp(batch.type_codes + 3 * 3, "RMC", 3) == 0);
+        TEST_CHECK(batch.statuses[4] == NMEA_MESSAGE_END_DELIMITER_NOT_FOUND);
+        TEST_CHECK(batch.message_offsets[4] == tailOffset && batch.message_lengths[4] == sizeof(tail) - 1);
+    }
+
+    TEST_CHECK(nmea_parse_batch(gga, sizeof(gga) - 1, &batch, 1) == NMEA_SUCCESS && batch.message_count == 1); // Arena is reused
+    nmea_destroy_batch(&batch);
+    TEST_CHECK(batch.arena == NULL && batch.message_count == 0);
+}
+
+void test_filter() {
+    static nmea_filter filter;
+    TEST_CHECK(nmea_init_filter(&filter, NMEA_FILTER_ALLOW) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_filter_add(&filter, "RMC") == NMEA_SUCCESS); // Any talker
+    TEST_CHECK(nmea_filter_add(&filter, "GPGGA") == NMEA_SUCCESS); // GPS talker only
+    TEST_CHECK(nmea_filter_add(&filter, "GGAX") == NMEA_MESSAGE_ID_LENGTH_INCORRECT);
+    TEST_CHECK(nmea_filter_add(&filter, "GPGGAX") == NMEA_MESSAGE_ID_LENGTH_INCORRECT);
+    TEST_CHECK(nmea_filter_add(&filter, "gga") == NMEA_MESSAGE_ID_LENGTH_INCORRECT);
+    TEST_CHECK(nmea_filter_add(&filter, "") == NMEA_MESSAGE_ID_LENGTH_INCORRECT);
+
+    static const char gpgga[] = "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n";
+    static const char gngga[] = "$GNGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*68\r\n";
+    static const char gnrmc[] = "$GNRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*5D\r\n";
+    static const char gpgsv[] = "$GPGSV,3,1,11,10,63,137,17,07,61,098,15,05,59,290,20,08,54,157,30*70\r\n$GPRMC";
+
+    nmea_parser parser;
+    nmea_init_parser(&parser);
+    TEST_CHECK(nmea_parser_set_filter(&parser, &filter) == NMEA_SUCCESS);
+
+    nmea_message* message;
+    size_t messageEndIndex;
+    size_t unfilteredEndIndex;
+    TEST_CHECK(nmea_parser_parse_message(&parser, gpgga, &message, &messageEndIndex, 0, NULL) == NMEA_SUCCESS);
+    nmea_destroy_message(&message);
+    TEST_CHECK(nmea_parser_parse_message(&parser, gnrmc, &message, &messageEndIndex, 0, NULL) == NMEA_SUCCESS);
+    nmea_destroy_message(&message);
+    TEST_CHECK(nmea_parser_parse_message(&parser, gngga, &message, &messageEndIndex, 0, NULL) == NMEA_MESSAGE_FILTERED); // Type listed for GP only
+
+    // Filtered out message is only framed, but ends where the parsed message would
+    TEST_CHECK(nmea_parse_message(gpgsv, &message, &unfilteredEndIndex, 0, NULL) == NMEA_SUCCESS);
+    nmea_destroy_message(&message);
+    TEST_CHECK(nmea_parser_parse_message(&parser, gpgsv, &message, &messageEndIndex, 0, NULL) == NMEA_MESSAGE_FILTERED);
+    TEST_CHECK(messageEndIndex == unfilteredEndIndex && gpgsv[messageEndIndex] != '\0');
+
+    TEST_CHECK(nmea_init_filter(&filter, NMEA_FILTER_DENY) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_filter_add(&filter, "GSV") == NMEA_SUCCESS);
+    TEST_CHECK(nmea_parser_parse_message(&parser, gpgsv, &message, &messageEndIndex, 0, NULL) == NMEA_MESSAGE_FILTERED);
+    TEST_CHECK(nmea_parser_parse_message(&parser, gngga, &message, &messageEndIndex, 0, NULL) == NMEA_SUCCESS);
+    nmea_destroy_message(&message);
+}
+
+typedef struct {
+    size_t callCount;
+    char lastId[6];
+} test_registry_result;
+
+int test_registry_handler(const nmea_field_view* view, void* user_data) {
+    test_registry_result* result = (test_registry_result*)user_data;
+    ++result->callCount;
+    memcpy(result->lastId, view->talker_id, 2);
+    memcpy(result->lastId + 2, view->type_code, 4);
+    return (int)view->field_count;
+}
+
+void test_registry() {
+    static nmea_registry registry;
+    test_registry_result gga;
+    test_registry_result vendor;
+    memset(&gga, 0, sizeof(gga));
+    memset(&vendor, 0, sizeof(vendor));
+
+    TEST_CHECK(nmea_init_registry(&registry) == NMEA_SUCCESS && registry.entry_count == 0);
+    TEST_CHECK(nmea_registry_add(&registry, "GPGGA", test_registry_handler, &gga) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_registry_add(&registry, "PUBX", test_registry_handler, &vendor) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_registry_add(&registry, "PGRMZ", test_registry_handler, &vendor) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_registry_add(&registry, "GPGGA", test_registry_handler, &gga) == NMEA_SUCCESS && registry.entry_count == 3); // Replaced
+    TEST_CHECK(nmea_registry_add(&registry, "GPGG", test_registry_handler, &gga) == NMEA_MESSAGE_ID_LENGTH_INCORRECT);
+    TEST_CHECK(nmea_registry_add(&registry, "PABCDEFGH", test_registry_handler, &gga) == NMEA_MESSAGE_ID_LENGTH_INCORRECT);
+    TEST_CHECK(nmea_registry_add(&registry, "GP,GA", test_registry_handler, &gga) == NMEA_MESSAGE_ID_LENGTH_INCORRECT);
+
+    nmea_field fields[NMEA_MESSAGE_MAX_FIELDS];
+    nmea_field_view view;
+    size_t messageEndIndex;
+    nmea_init_field_view(&view, fields, NMEA_MESSAGE_MAX_FIELDS);
+    TEST_CHECK(nmea_dispatch_message(&registry, "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n", &view, &messageEndIndex, 1) == 14);
+    TEST_CHECK(gga.callCount == 1 && strcmp(gga.lastId, "GPGGA") == 0 && vendor.callCount == 0);
+    TEST_CHECK(nmea_dispatch_message(&registry, "$PUBX,00,123\r\n", &view, &messageEndIndex, 0) == 2);
+    TEST_CHECK(vendor.callCount == 1 && strcmp(vendor.lastId, "PUBX") == 0 && messageEndIndex == 13);
+    TEST_CHECK(nmea_dispatch_message(&registry, "$PGRMZ,246,f,3\r\n", &view, &messageEndIndex, 0) == 3);
+    TEST_CHECK(vendor.callCount == 2 && strcmp(vendor.lastId, "PGRMZ") == 0);
+    TEST_CHECK(nmea_dispatch_message(&registry, "$GNGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*68\r\n", &view, &messageEndIndex, 0) == NMEA_UNSUPPORTED_MESSAGE);
+    TEST_CHECK(nmea_dispatch_message(&registry, "$PGRME,15.0,M\r\n", &view, &messageEndIndex, 0) == NMEA_UNHANDLED_VENDOR_EXT_MESSAGE);
+    TEST_CHECK(nmea_dispatch_message(&registry, "$GPGGA,1*00\r\n", &view, &messageEndIndex, 0) == NMEA_CHECKSUM_ERROR && gga.callCount == 1);
+}
+
+int test_decode_str(const char* str, nmea_decoded* decoded) {
+    nmea_field fields[NMEA_MESSAGE_MAX_FIELDS];
+    nmea_field_view view;
+    size_t messageEndIndex;
+    nmea_init_field_view(&view, fields, NMEA_MESSAGE_MAX_FIELDS);
+    const int return_value = nmea_parse_field_view(str, &view, &messageEndIndex, 0);
+    return return_value != NMEA_SUCCESS ? return_value : nmea_decode(&view, decoded);
+}
+
+int test_near(const double value, const double expected) {
+    return fabs(value - expected) < 1e-6;
+}
+
+void test_decode() {
+    nmea_decoded decoded;
+    const double lat = 53.0 + 21.6802 / 60.0;
+    const double lon = 6.0 + 30.3372 / 60.0;
+    const uint32_t timeMs = 34070000u; // 09:27:50.000
+
+    TEST_CHECK(test_decode_str("$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n", &decoded) == NMEA_SUCCESS);
+    TEST_CHECK(decoded.type == NMEA_DECODED_GGA && decoded.data.gga.time_ms == timeMs);
+    TEST_CHECK(test_near(decoded.data.gga.lat, lat) && test_near(decoded.data.gga.lon, -lon));
+    TEST_CHECK(decoded.data.gga.fix == 1 && decoded.data.gga.sats == 8);
+    TEST_CHECK(decoded.data.gga.hdop == 1.03f && decoded.data.gga.alt == 61.7f && decoded.data.gga.geoid_separation == 55.2f);
+
+    TEST_CHECK(test_decode_str("$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*43\r\n", &decoded) == NMEA_SUCCESS);
+    TEST_CHECK(decoded.type == NMEA_DECODED_RMC && decoded.data.rmc.time_ms == timeMs && decoded.data.rmc.status == 'A');
+    TEST_CHECK(test_near(decoded.data.rmc.lat, lat) && test_near(decoded.data.rmc.lon, -lon));
+    TEST_CHECK(decoded.data.rmc.speed_knots == 0.02f && decoded.data.rmc.course == 31.66f);
+    TEST_CHECK(decoded.data.rmc.date == 15122 && isnan(decoded.data.rmc.magnetic_variation) && decoded.data.rmc.mode == 'A'); // 2011-05-28
+    TEST_CHECK(test_decode_str("$GPRMC,235959.5,V,5321.6802,S,00630.3372,E,0.02,31.66,010100,3.1,W\r\n", &decoded) == NMEA_SUCCESS); // NMEA 2.2: no mode
+    TEST_CHECK(decoded.data.rmc.time_ms == 86399500u && decoded.data.rmc.status == 'V');
+    TEST_CHECK(test_near(decoded.data.rmc.lat, -lat) && test_near(decoded.data.rmc.lon, lon));
+    TEST_CHECK(decoded.data.rmc.date == 10957 && decoded.data.rmc.magnetic_variation == -3.1f && decoded.data.rmc.mode == '\0'); // 2000-01-01
+
+    static const uint16_t satelliteIds[12] = { 10, 7, 5, 2, 29, 4, 8, 13, 0, 0, 0, 0 };
+    TEST_CHECK(test_decode_str("$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*0A\r\n", &decoded) == NMEA_SUCCESS);
+    TEST_CHECK(decoded.type == NMEA_DECODED_GSA && decoded.data.gsa.mode == 'A' && decoded.data.gsa.fix_type == 3);
+    TEST_CHECK(memcmp(decoded.data.gsa.satellite_ids, satelliteIds, sizeof(satelliteIds)) == 0);
+    TEST_CHECK(decoded.data.gsa.pdop == 1.72f && decoded.data.gsa.hdop == 1.03f && decoded.data.gsa.vdop == 1.38f);
+
+    TEST_CHECK(test_decode_str("$GPGSV,3,3,11,29,09,301,24,16,09,020,,36,,,*76\r\n", &decoded) == NMEA_SUCCESS);
+    TEST_CHECK(decoded.type == NMEA_DECODED_GSV && decoded.data.gsv.message_count == 3 && decoded.data.gsv.message_number == 3);
+    TEST_CHECK(decoded.data.gsv.sats_in_view == 11 && decoded.data.gsv.satellite_count == 3);
+    TEST_CHECK(decoded.data.gsv.satellites[0].prn == 29 && decoded.data.gsv.satellites[0].elevation == 9);
+    TEST_CHECK(decoded.data.gsv.satellites[0].azimuth == 301 && decoded.data.gsv.satellites[0].snr == 24);
+    TEST_CHECK(decoded.data.gsv.satellites[1].prn == 16 && decoded.data.gsv.satellites[1].azimuth == 20 && decoded.data.gsv.satellites[1].snr == 0); // Not tracked
+    TEST_CHECK(decoded.data.gsv.satellites[2].prn == 36 && decoded.data.gsv.satellites[2].elevation == 0 && decoded.data.gsv.satellites[2].azimuth == 0);
+    TEST_CHECK(test_decode_str("$GPGSV,1,1,00\r\n", &decoded) == NMEA_SUCCESS && decoded.data.gsv.satellite_count == 0);
+
+    TEST_CHECK(test_decode_str("$GPVTG,31.66,T,,M,0.02,N,0.04,K,A\r\n", &decoded) == NMEA_SUCCESS);
+    TEST_CHECK(decoded.type == NMEA_DECODED_VTG && decoded.data.vtg.course_true == 31.66f && isnan(decoded.data.vtg.course_magnetic));
+    TEST_CHECK(decoded.data.vtg.speed_knots == 0.02f && decoded.data.vtg.speed_kmh == 0.04f && decoded.data.vtg.mode == 'A');
+
+    TEST_CHECK(test_decode_str("$GPGLL,5321.6802,N,00630.3372,W,092750.000,A,D\r\n", &decoded) == NMEA_SUCCESS);
+    TEST_CHECK(decoded.type == NMEA_DECODED_GLL && test_near(decoded.data.gll.lat, lat) && test_near(decoded.data.gll.lon, -lon));
+    TEST_CHECK(decoded.data.gll.time_ms == timeMs && decoded.data.gll.status == 'A' && decoded.data.gll.mode == 'D');
+
+    // Empty fields decode to "not available" values
+    TEST_CHECK(test_decode_str("$GPGGA,,,,,,,,,,,,,,\r\n", &decoded) == NMEA_SUCCESS && decoded.type == NMEA_DECODED_GGA);
+    TEST_CHECK(decoded.data.gga.time_ms == NMEA_TIME_INVALID && isnan(decoded.data.gga.lat) && isnan(decoded.data.gga.lon));
+    TEST_CHECK(decoded.data.gga.fix == 0 && decoded.data.gga.sats == 0 && isnan(decoded.data.gga.hdop));
+    TEST_CHECK(test_decode_str("$GPRMC,,V,,,,,,,,,\r\n", &decoded) == NMEA_SUCCESS && decoded.data.rmc.date == NMEA_DATE_INVALID);
+
+    // Unknown type, missing fields and bad values are rejected without decoded type
+    TEST_CHECK(test_decode_str("$GPZDA,092750.000,28,05,2011,,\r\n", &decoded) == NMEA_UNSUPPORTED_MESSAGE && decoded.type == NMEA_DECODED_NONE);
+    TEST_CHECK(test_decode_str("$PGRMZ,246,f,3\r\n", &decoded) == NMEA_UNSUPPORTED_MESSAGE && decoded.type == NMEA_DECODED_NONE);
+    TEST_CHECK(test_decode_str("$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M\r\n", &decoded) == NMEA_FIELD_COUNT_INCORRECT);
+    TEST_CHECK(decoded.type == NMEA_DECODED_NONE);
+    TEST_CHECK(test_decode_str("$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,\r\n", &decoded) == NMEA_FIELD_COUNT_INCORRECT);
+    TEST_CHECK(test_decode_str("$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03\r\n", &decoded) == NMEA_FIELD_COUNT_INCORRECT);
+    TEST_CHECK(test_decode_str("$GPGSV,3,3\r\n", &decoded) == NMEA_FIELD_COUNT_INCORRECT);
+    TEST_CHECK(test_decode_str("$GPVTG,31.66,T,,M,0.02,N,0.04\r\n", &decoded) == NMEA_FIELD_COUNT_INCORRECT);
+    TEST_CHECK(test_decode_str("$GPGLL,5321.6802,N,00630.3372,W,092750.000\r\n", &decoded) == NMEA_FIELD_COUNT_INCORRECT);
+    TEST_CHECK(test_decode_str("$GPGGA,092750.000,5321.6802,X,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,\r\n", &decoded) == NMEA_HEMISPHERE_INCORRECT);
+    TEST_CHECK(decoded.type == NMEA_DECODED_NONE);
+    TEST_CHECK(test_decode_str("$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,256,1.03,61.7,M,55.2,M,,\r\n", &decoded) == NMEA_NUMBER_OUT_OF_RANGE);
+    TEST_CHECK(test_decode_str("$GPGSA,AA,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38\r\n", &decoded) == NMEA_FIELD_VALUE_INCORRECT);
+}
+
+int test_epoch_add(nmea_epoch_assembler* assembler, const char* str, const nmea_epoch_fix** fix) {
+    nmea_field fields[NMEA_MESSAGE_MAX_FIELDS];
+    nmea_field_view view;
+    nmea_decoded decoded;
+    size_t messageEndIndex;
+    *fix = NULL;
+    nmea_init_field_view(&view, fields, NMEA_MESSAGE_MAX_FIELDS);
+    if(nmea_parse_field_view(str, &view, &messageEndIndex, 0) != NMEA_SUCCESS || nmea_decode(&view, &decoded) != NMEA_SUCCESS) {
+        return NMEA_UNKNOWN_ERROR;
+    }
+    return nmea_epoch_add(assembler, &decoded, fix);
+}
+
+void test_epoch() {
+    static const char gga[] = "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n";
+    static const char gsa[] = "$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*0A\r\n";
+    static const char gsv1[] = "$GPGSV,3,1,11,10,63,137,17,07,61,098,15,05,59,290,20,08,54,157,30*70\r\n";
+    static const char gsv2[] = "$GPGSV,3,2,11,02,39,223,19,13,28,070,17,26,23,252,,04,14,186,14*79\r\n";
+    static const char gsv3[] = "$GPGSV,3,3,11,29,09,301,24,16,09,020,,36,,,*76\r\n";
+    static const char rmc[] = "$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*43\r\n";
+    static const char ggaNext[] = "$GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,*75\r\n";
+    static const char rmcNext[] = "$GPRMC,092751.000,A,5321.6802,N,00630.3371,W,0.06,31.66,280511,,,A*45\r\n";
+
+    static nmea_epoch_assembler assembler;
+    const nmea_epoch_fix* fix;
+
+    // Full burst completes epoch on its last expected sentence
+    nmea_init_epoch_assembler(&assembler, NMEA_EPOCH_GGA | NMEA_EPOCH_RMC | NMEA_EPOCH_GSA | NMEA_EPOCH_GSV);
+    TEST_CHECK(test_epoch_add(&assembler, gga, &fix) == NMEA_SUCCESS && fix == NULL);
+    TEST_CHECK(test_epoch_add(&assembler, gsa, &fix) == NMEA_SUCCESS && fix == NULL);
+    TEST_CHECK(test_epoch_add(&assembler, gsv1, &fix) == NMEA_SUCCESS && fix == NULL);
+    TEST_CHECK(test_epoch_add(&assembler, gsv2, &fix) == NMEA_SUCCESS && fix == NULL);
+    TEST_CHECK(test_epoch_add(&assembler, gsv3, &fix) == NMEA_SUCCESS && fix == NULL);
+    TEST_CHECK(test_epoch_add(&assembler, rmc, &fix) == NMEA_SUCCESS && fix != NULL);
+    if(fix != NULL) {
+        TEST_CHECK(fix->sentences == (NMEA_EPOCH_GGA | NMEA_EPOCH_RMC | NMEA_EPOCH_GSA | NMEA_EPOCH_GSV));
+        TEST_CHECK(fix->time_ms == 34070000u && fix->date == 15122u && fix->status == 'A');
+        TEST_CHECK(fix->lat > 53.361336 && fix->lat < 53.361337 && fix->fix_quality == 1 && fix->fix_type == 3);
+        TEST_CHECK(fix->used_count == 8 && fix->used_ids[0] == 10 && fix->sats_in_view == 11 && fix->satellite_count == 11);
+    }
+    TEST_CHECK(nmea_epoch_flush(&assembler, &fix) == NMEA_SUCCESS && fix == NULL); // Nothing merged since report
+
+    // GSV parts out of sequence
+    nmea_init_epoch_assembler(&assembler, NMEA_EPOCH_GSV);
+    TEST_CHECK(test_epoch_add(&assembler, gsv2, &fix) == NMEA_EPOCH_SEQUENCE_INCORRECT && fix == NULL);
+    TEST_CHECK(test_epoch_add(&assembler, gsv1, &fix) == NMEA_SUCCESS && fix == NULL);
+    TEST_CHECK(test_epoch_add(&assembler, gsv3, &fix) == NMEA_EPOCH_SEQUENCE_INCORRECT && fix == NULL); // Part 2 lost
+    TEST_CHECK(test_epoch_add(&assembler, gsv1, &fix) == NMEA_SUCCESS && fix == NULL);
+    TEST_CHECK(test_epoch_add(&assembler, gsv2, &fix) == NMEA_SUCCESS && fix == NULL);
+    TEST_CHECK(test_epoch_add(&assembler, gsv3, &fix) == NMEA_SUCCESS && fix != NULL);
+
+    // Sentence with next UTC time reports incomplete epoch; Flush reports the rest
+    nmea_init_epoch_assembler(&assembler, NMEA_EPOCH_GGA | NMEA_EPOCH_RMC | NMEA_EPOCH_VTG);
+    TEST_CHECK(test_epoch_add(&assembler, gga, &fix) == NMEA_SUCCESS && fix == NULL);
+    TEST_CHECK(test_epoch_add(&assembler, rmc, &fix) == NMEA_SUCCESS && fix == NULL);
+    TEST_CHECK(test_epoch_add(&assembler, ggaNext, &fix) == NMEA_SUCCESS && fix != NULL);
+    TEST_CHECK(fix != NULL && fix->time_ms == 34070000u && fix->sentences == (NMEA_EPOCH_GGA | NMEA_EPOCH_RMC));
+    TEST_CHECK(nmea_epoch_flush(&assembler, &fix) == NMEA_SUCCESS && fix != NULL);
+    TEST_CHECK(fix != NULL && fix->time_ms == 34071000u && fix->sentences == NMEA_EPOCH_GGA && fix->date == NMEA_DATE_INVALID);
+    TEST_CHECK(nmea_epoch_flush(&assembler, &fix) == NMEA_SUCCESS && fix == NULL);
+
+    // Epoch completed by sentence that also timed out previous epoch is reported by next call
+    nmea_init_epoch_assembler(&assembler, NMEA_EPOCH_RMC);
+    TEST_CHECK(test_epoch_add(&assembler, gga, &fix) == NMEA_SUCCESS && fix == NULL);
+    TEST_CHECK(test_epoch_add(&assembler, rmcNext, &fix) == NMEA_SUCCESS && fix != NULL && assembler.pending != 0);
+    TEST_CHECK(fix != NULL && fix->time_ms == 34070000u && fix->sentences == NMEA_EPOCH_GGA);
+    TEST_CHECK(test_epoch_add(&assembler, gsa, &fix) == NMEA_SUCCESS && fix != NULL);
+    TEST_CHECK(fix != NULL && fix->time_ms == 34071000u && fix->sentences == NMEA_EPOCH_RMC);
+    TEST_CHECK(nmea_epoch_flush(&assembler, &fix) == NMEA_SUCCESS && fix != NULL && fix->sentences == NMEA_EPOCH_GSA);
+}
+
+void test_writer() {
+    static const char gga[] = "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n";
+    static const char rmc[] = "$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*43\r\n";
+    const size_t ggaLength = sizeof(gga) - 1;
+    const size_t rmcLength = sizeof(rmc) - 1;
+
+    nmea_message* messages[2];
+    size_t messageEndIndex;
+    TEST_CHECK(nmea_parse_message(gga, &messages[0], &messageEndIndex, 1, NULL) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_parse_message(rmc, &messages[1], &messageEndIndex, 1, NULL) == NMEA_SUCCESS);
+
+    char buffer[256];
+    size_t written;
+    TEST_CHECK(nmea_message_write(messages[0], buffer, sizeof(buffer), &written) == NMEA_SUCCESS);
+    TEST_CHECK(written == ggaLength && memcmp(buffer, gga, ggaLength) == 0); // Checksum is regenerated
+    TEST_CHECK(nmea_message_write(messages[0], buffer, ggaLength, &written) == NMEA_SUCCESS && written == ggaLength); // Exact fit
+    TEST_CHECK(nmea_message_write(messages[0], buffer, ggaLength - 1, &written) == NMEA_BUFFER_TOO_SMALL && written == 0);
+    TEST_CHECK(nmea_message_write(messages[0], NULL, 0, &written) == NMEA_BUFFER_TOO_SMALL);
+
+    // Ring wraps at its end
+    char ring[96];
+    const size_t writeIndex = sizeof(ring) - 10;
+    TEST_CHECK(nmea_message_write_ring(messages[0], ring, sizeof(ring), writeIndex, sizeof(ring), &written) == NMEA_SUCCESS && written == ggaLength);
+    TEST_CHECK(memcmp(ring + writeIndex, gga, 10) == 0 && memcmp(ring, gga + 10, ggaLength - 10) == 0);
+    TEST_CHECK(nmea_message_write_ring(messages[0], ring, sizeof(ring), writeIndex, ggaLength - 1, &written) == NMEA_BUFFER_TOO_SMALL && written == 0);
+
+    // Packing stops at first message that does not fit
+    size_t messagesWritten;
+    const nmea_message* const* packed = (const nmea_message* const*)messages;
+    TEST_CHECK(nmea_messages_write(packed, 2, buffer, sizeof(buffer), &written, &messagesWritten) == NMEA_SUCCESS);
+    TEST_CHECK(messagesWritten == 2 && written == ggaLength + rmcLength);
+    TEST_CHECK(memcmp(buffer, gga, ggaLength) == 0 && memcmp(buffer + ggaLength, rmc, rmcLength) == 0);
+    TEST_CHECK(nmea_messages_write(packed, 2, buffer, ggaLength + rmcLength - 1, &written, &messagesWritten) == NMEA_SUCCESS);
+    TEST_CHECK(messagesWritten == 1 && written == ggaLength);
+    TEST_CHECK(nmea_messages_write(packed, 2, buffer, ggaLength - 1, &written, &messagesWritten) == NMEA_BUFFER_TOO_SMALL);
+    TEST_CHECK(messagesWritten == 0 && written == 0);
+
+    nmea_destroy_message(&messages[0]);
+    nmea_destroy_message(&messages[1]);
+}
+
+int test_ais_add(nmea_ais_assembler* assembler, const char* str, const nmea_ais_payload** payload) {
+    nmea_field fields[NMEA_MESSAGE_MAX_FIELDS];
+    nmea_field_view view;
+    size_t messageEndIndex;
+    *payload = NULL;
+    nmea_init_field_view(&view, fields, NMEA_MESSAGE_MAX_FIELDS);
+    if(nmea_parse_field_view(str, &view, &messageEndIndex, 1) != NMEA_SUCCESS) {
+        return NMEA_UNKNOWN_ERROR;
+    }
+    return nmea_ais_add_fragment(assembler, &view, payload);
+}
+
+void test_ais() {
+    static const char single[] = "!AIVDM,1,1,,B,177KQJ5000G?tO`K>RA1wUbN0TKH,0*5C\r\n";
+    static const char first[] = "!AIVDM,2,1,1,A,55?MbV02;H;s<HtKR20EHE:0@T4@Dn2222222216L961O5Gf0NSQEp6ClRp8,0*1C\r\n";
+    static const char second[] = "!AIVDM,2,2,1,A,88888888880,2*25\r\n";
+
+    static nmea_ais_payload payload;
+    uint32_t value;
+    int32_t signedValue;
+    TEST_CHECK(nmea_ais_unarmor("177KQJ5000G?tO`K>RA1wUbN0TKH", 28, 0, &payload) == NMEA_SUCCESS && payload.bit_count == 168);
+    TEST_CHECK(nmea_ais_get_uint(&payload, 0, 6, &value) == NMEA_SUCCESS && value == 1); // Position report
+    TEST_CHECK(nmea_ais_get_uint(&payload, 8, 30, &value) == NMEA_SUCCESS && value == 477553000u); // MMSI
+    TEST_CHECK(nmea_ais_get_uint(&payload, 38, 4, &value) == NMEA_SUCCESS && value == 5); // Moored
+    TEST_CHECK(nmea_ais_get_int(&payload, 61, 28, &signedValue) == NMEA_SUCCESS && signedValue == -73407500); // Longitude (1/10000 minutes)
+    TEST_CHECK(nmea_ais_get_int(&payload, 89, 27, &signedValue) == NMEA_SUCCESS && signedValue == 28549700); // Latitude
+    TEST_CHECK(nmea_ais_get_uint(&payload, 128, 9, &value) == NMEA_SUCCESS && value == 181); // Heading
+    TEST_CHECK(nmea_ais_get_uint(&payload, 160, 9, &value) == NMEA_AIS_PAYLOAD_INCORRECT); // Past payload end
+    TEST_CHECK(nmea_ais_unarmor("1X", 2, 0, &payload) == NMEA_AIS_PAYLOAD_INCORRECT);
+    TEST_CHECK(nmea_ais_unarmor("88888888880", 11, 2, &payload) == NMEA_SUCCESS && payload.bit_count == 64);
+
+    static nmea_ais_assembler assembler;
+    const nmea_ais_payload* completed;
+    nmea_init_ais_assembler(&assembler);
+    TEST_CHECK(test_ais_add(&assembler, single, &completed) == NMEA_SUCCESS && completed != NULL);
+    TEST_CHECK(completed != NULL && completed->bit_count == 168 && completed->channel == 'B');
+
+    // Static and voyage data in two fragments
+    TEST_CHECK(test_ais_add(&assembler, first, &completed) == NMEA_SUCCESS && completed == NULL);
+    TEST_CHECK(test_ais_add(&assembler, second, &completed) == NMEA_SUCCESS && completed != NULL);
+    if(completed != NULL) {
+        char name[21];
+        TEST_CHECK(completed->bit_count == 424 && completed->channel == 'A');
+        TEST_CHECK(nmea_ais_get_uint(completed, 0, 6, &value) == NMEA_SUCCESS && value == 5);
+        TEST_CHECK(nmea_ais_get_uint(completed, 8, 30, &value) == NMEA_SUCCESS && value == 351759000u);
+        TEST_CHECK(nmea_ais_get_text(completed, 112, 20, name) == NMEA_SUCCESS && strcmp(name, "EVER DIADEM         ") == 0);
+        TEST_CHECK(nmea_ais_get_text(completed, 302, 20, name) == NMEA_SUCCESS && strcmp(name, "NEW YORK            ") == 0); // Destination spans both fragments
+    }
+
+    // Fragments out of order
+    TEST_CHECK(test_ais_add(&assembler, second, &completed) == NMEA_AIS_FRAGMENT_INCORRECT && completed == NULL);
+    TEST_CHECK(test_ais_add(&assembler, first, &completed) == NMEA_SUCCESS && completed == NULL);
+    TEST_CHECK(test_ais_add(&assembler, first, &completed) == NMEA_SUCCESS && completed == NULL); // Restarts message
+    TEST_CHECK(test_ais_add(&assembler, second, &completed) == NMEA_SUCCESS && completed != NULL);
+    TEST_CHECK(test_ais_add(&assembler, second, &completed) == NMEA_AIS_FRAGMENT_INCORRECT && completed == NULL); // Repeated
+}
+
+size_t test_archive_count(const nmea_archive_reader* reader, const uint64_t beginKey, const uint64_t endKey, const char* id) { // Records of range query
+    nmea_archive_cursor cursor;
+    const nmea_archive_record* record;
+    size_t count = 0;
+    if(nmea_archive_seek(reader, &cursor, beginKey, endKey, id) != NMEA_SUCCESS) {
+        return (size_t)-1;
+    }
+    while(nmea_archive_next(&cursor, &record) == NMEA_SUCCESS && record != NULL) {
+        if(record->time_key < beginKey || record->time_key > endKey) {
+            return (size_t)-1;
+        }
+        ++count;
+    }
+    return count;
+}
+
+typedef struct {
+    size_t* lengths; // Message length by message offset in file (0 = no message there)
+    int* statuses; // Message status by message offset in file
+    size_t* fieldOffsets; // Offset of first field in file by message offset in file
+    unsigned* hits; // Number of times message was delivered by message offset in file
+    const char* data; // File content
+    size_t sinkCalls; // Ordered mode only (unordered sink runs concurrently)
+    size_t lastOffset; // Ordered mode only: offset of last delivered message + 1
+    int inOrder; // Ordered mode only
+} test_parallel_result;
+
+void test_parallel_sink(const nmea_batch* batch, const char* chunk, const size_t chunk_offset, void* user_data) {
+    test_parallel_result* result = (test_parallel_result*)user_data;
+    for(size_t i = 0; i < batch->message_count; ++i) { // Chunks do not overlap, so concurrent sinks write different slots
+        const size_t offset = chunk_offset + batch->message_offsets[i];
+        if(memcmp(chunk + batch->message_offsets[i], result->data + offset, batch->message_lengths[i]) != 0) { // Left undelivered
+            continue;
+        }
+        result->lengths[offset] = batch->message_lengths[i];
+        result->statuses[offset] = batch->statuses[i];
+        result->fieldOffsets[offset] = batch->field_counts[i] != 0 ? chunk_offset + batch->fields[batch->first_fields[i]].offset : 0;
+        ++result->hits[offset];
+    }
+}
+
+void test_parallel_ordered_sink(const nmea_batch* batch, const char* chunk, const size_t chunk_offset, void* user_data) {
+    test_parallel_result* result = (test_parallel_result*)user_data;
+    ++result->sinkCalls;
+    for(size_t i = 0; i < batch->message_count; ++i) {
+        const size_t offset = chunk_offset + batch->message_offsets[i];
+        if(offset + 1 <= result->lastOffset) {
+            result->inOrder = 0;
+        }
+        result->lastOffset = offset + 1;
+    }
+    test_parallel_sink(batch, chunk, chunk_offset, user_data);
+}
+
+void test_parallel_reset(test_parallel_result* result, const char* data, const size_t size) {
+    memset(result->lengths, 0, size * sizeof(size_t));
+    memset(result->statuses, 0, size * sizeof(int));
+    memset(result->fieldOffsets, 0, size * sizeof(size_t));
+    memset(result->hits, 0, size * sizeof(unsigned));
+    result->data = data;
+    result->sinkCalls = 0;
+    result->lastOffset = 0;
+    result->inOrder = 1;
+}
+
+int test_parallel_matches(const test_parallel_result* result, const nmea_batch* expected, const size_t size) { // Same messages as single-threaded batch
+    size_t delivered = 0;
+    for(size_t offset = 0; offset < size; ++offset) {
+        delivered += result->hits[offset];
+    }
+    if(delivered != expected->message_count) {
+        return 0;
+    }
+    for(size_t i = 0; i < expected->message_count; ++i) {
+        const size_t offset = expected->message_offsets[i];
+        const size_t fieldOffset = expected->field_counts[i] != 0 ? expected->fields[expected->first_fields[i]].offset : 0;
+        if(result->hits[offset] != 1 || result->lengths[offset] != expected->message_lengths[i]
+            || result->statuses[offset] != expected->statuses[i] || result->fieldOffsets[offset] != fieldOffset) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void test_parallel() {
+    static const char* const sentences[] = {
+        "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n",
+        "$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*0A\r\n",
+        "$GPGSV,3,1,11,10,63,137,17,07,61,098,15,05,59,290,20,08,54,157,30*70\r\n",
+        "$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*42\n", // Bad checksum
+        "no sentence on this line\r\n",
+        "!AIVDM,1,1,,A,13aEOK?P00PD2wVMdLDRhgvL289?,0*26\n",
+        "$GPVTG,31.66,T,,M,0.02,N,0.04,K,A*3F\r\n",
+        "$GPGLL,5321.6802,N,00630.3372,W,092750.000,A,A*43\n"
+    };
+    static const char path[] = "test_parallel.log";
+    const size_t sentenceCount = sizeof(sentences) / sizeof(sentences[0]);
+    const size_t lineCount = 997; // Chunk split points fall inside lines
+
+    size_t size = 0;
+    size_t messageCount = 0; // Noise lines are skipped
+    for(size_t i = 0; i < lineCount; ++i) {
+        size += strlen(sentences[(i * 5) % sentenceCount]);
+        messageCount += sentences[(i * 5) % sentenceCount][0] != 'n';
+    }
+    char* data = (char*)malloc(size);
+    test_parallel_result result;
+    result.lengths = (size_t*)malloc(size * sizeof(size_t));
+    result.statuses = (int*)malloc(size * sizeof(int));
+    result.fieldOffsets = (size_t*)malloc(size * sizeof(size_t));
+    result.hits = (unsigned*)malloc(size * sizeof(unsigned));
+    TEST_CHECK(data != NULL && result.lengths != NULL && result.statuses != NULL && result.fieldOffsets != NULL && result.hits != NULL);
+    if(data == NULL || result.lengths == NULL || result.statuses == NULL || result.fieldOffsets == NULL || result.hits == NULL) {
+        free(data);
+        free(result.lengths);
+        free(result.statuses);
+        free(result.fieldOffsets);
+        free(result.hits);
+        return;
+    }
+    size_t length = 0;
+    for(size_t i = 0; i < lineCount; ++i) {
+        const char* sentence = sentences[(i * 5) % sentenceCount];
+        memcpy(data + length, sentence, strlen(sentence));
+        length += strlen(sentence);
+    }
+
+    FILE* file = fopen(path, "wb");
+    TEST_CHECK(file != NULL && fwrite(data, 1, size, file) == size);
+    if(file != NULL) {
+        fclose(file);
+    }
+
+    nmea_batch expected;
+    nmea_init_batch(&expected);
+    TEST_CHECK(nmea_parse_batch(data, size, &expected, 0) == NMEA_SUCCESS);
+    TEST_CHECK(expected.message_count == messageCount);
+
+    // Every thread count splits file differently; Ordered, unordered and single-threaded results are the same
+    static const size_t threadCounts[] = { 0, 1, 2, 3, 8, 13 };
+    for(size_t i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]); ++i) {
+        test_parallel_reset(&result, data, size);
+        TEST_CHECK(nmea_parse_file_parallel(path, threadCounts[i], 0, 0, test_parallel_sink, &result) == NMEA_SUCCESS);
+        TEST_CHECK(test_parallel_matches(&result, &expected, size));
+
+        test_parallel_reset(&result, data, size);
+        TEST_CHECK(nmea_parse_file_parallel(path, threadCounts[i], 0, 1, test_parallel_ordered_sink, &result) == NMEA_SUCCESS);
+        TEST_CHECK(test_parallel_matches(&result, &expected, size));
+        TEST_CHECK(result.inOrder && result.lastOffset == expected.message_offsets[expected.message_count - 1] + 1);
+        TEST_CHECK(result.sinkCalls == (threadCounts[i] <= 1 ? 1 : threadCounts[i])); // File is far below NMEA_PARALLEL_CHUNK_SIZE
+    }
+
+    // Strict mode is passed to every chunk
+    nmea_parse_batch(data, size, &expected, 1);
+    test_parallel_reset(&result, data, size);
+    TEST_CHECK(nmea_parse_file_parallel(path, 4, 1, 1, test_parallel_ordered_sink, &result) == NMEA_SUCCESS);
+    TEST_CHECK(test_parallel_matches(&result, &expected, size) && result.inOrder);
+
+    // Empty file is not mapped and has no chunks
+    file = fopen(path, "wb");
+    TEST_CHECK(file != NULL);
+    if(file != NULL) {
+        fclose(file);
+    }
+    test_parallel_reset(&result, data, size);
+    TEST_CHECK(nmea_parse_file_parallel(path, 4, 0, 1, test_parallel_ordered_sink, &result) == NMEA_SUCCESS);
+    TEST_CHECK(result.sinkCalls == 0);
+    remove(path);
+    TEST_CHECK(nmea_parse_file_parallel(path, 4, 0, 0, test_parallel_sink, &result) != NMEA_SUCCESS); // Missing file
+
+    nmea_destroy_batch(&expected);
+    free(data);
+    free(result.lengths);
+    free(result.statuses);
+    free(result.fieldOffsets);
+    free(result.hits);
+}
+
+void test_archive() {
+    static const char* const sentences[] = {
+        "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n",
+        "$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*0A\r\n",
+        "$GPGSV,3,1,11,10,63,137,17,07,61,098,15,05,59,290,20,08,54,157,30*70\r\n",
+        "$GPGSV,3,2,11,02,39,223,19,13,28,070,17,26,23,252,,04,14,186,14*79\r\n",
+        "$GPGSV,3,3,11,29,09,301,24,16,09,020,,36,,,*76\r\n",
+        "$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*43\r\n"
+    };
+    const size_t sentenceCount = sizeof(sentences) / sizeof(sentences[0]);
+    const size_t epochCount = 300; // GGA + RMC each; Spans several index blocks
+    static const char dataPath[] = "test_archive.dat";
+    static const char indexPath[] = "test_archive.idx";
+    const uint64_t dayKey = UINT64_C(15122) * 86400000; // 2011-05-28
+
+    nmea_archive_writer writer;
+    TEST_CHECK(nmea_archive_open_writer(&writer, dataPath, indexPath) == NMEA_SUCCESS);
+    nmea_message* message;
+    size_t messageEndIndex;
+    for(size_t i = 0; i < sentenceCount; ++i) {
+        TEST_CHECK(nmea_parse_message(sentences[i], &message, &messageEndIndex, 1, NULL) == NMEA_SUCCESS);
+        TEST_CHECK(nmea_archive_append(&writer, message) == NMEA_SUCCESS);
+        nmea_destroy_message(&message);
+    }
+    for(size_t i = 0; i < epochCount; ++i) { // 10:00:00 + i seconds (no checksum)
+        char sentence[NMEA_MESSAGE_MAX_LENGTH + 1];
+        snprintf(sentence, sizeof(sentence), "$GPGGA,10%02u%02u.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,\r\n", (unsigned)(i / 60), (unsigned)(i % 60));
+        TEST_CHECK(nmea_parse_message(sentence, &message, &messageEndIndex, 0, NULL) == NMEA_SUCCESS);
+        TEST_CHECK(nmea_archive_append(&writer, message) == NMEA_SUCCESS);
+        nmea_destroy_message(&message);
+        snprintf(sentence, sizeof(sentence), "$GPRMC,10%02u%02u.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A\r\n", (unsigned)(i / 60), (unsigned)(i % 60));
+        TEST_CHECK(nmea_parse_message(sentence, &message, &messageEndIndex, 0, NULL) == NMEA_SUCCESS);
+        TEST_CHECK(nmea_archive_append(&writer, message) == NMEA_SUCCESS);
+        nmea_destroy_message(&message);
+    }
+    TEST_CHECK(nmea_archive_close_writer(&writer) == NMEA_SUCCESS);
+
+    nmea_archive_reader reader;
+    TEST_CHECK(nmea_archive_open_reader(&reader, dataPath, indexPath) == NMEA_SUCCESS);
+    TEST_CHECK(reader.entry_count == (sentenceCount + 2 * epochCount + NMEA_ARCHIVE_INDEX_INTERVAL - 1) / NMEA_ARCHIVE_INDEX_INTERVAL);
+
+    // Round trip: regenerated sentences equal archived ones
+    nmea_archive_cursor cursor;
+    const nmea_archive_record* record;
+    TEST_CHECK(nmea_archive_seek(&reader, &cursor, 0, UINT64_MAX, NULL) == NMEA_SUCCESS);
+    for(size_t i = 0; i < sentenceCount; ++i) {
+        TEST_CHECK(nmea_archive_next(&cursor, &record) == NMEA_SUCCESS && record != NULL);
+        if(record == NULL) {
+            break;
+        }
+        char* str;
+        TEST_CHECK(nmea_archive_record_to_message(record, NULL, &message) == NMEA_SUCCESS);
+        TEST_CHECK(nmea_message_to_string(message, &str) == NMEA_SUCCESS && strcmp(str, sentences[i]) == 0);
+        nmea_destroy_message_string(&str);
+        nmea_destroy_message(&message);
+    }
+    TEST_CHECK(record != NULL && record->time_key == dayKey + 34070000u); // RMC carries date
+    TEST_CHECK(test_archive_count(&reader, 0, UINT64_MAX, NULL) == sentenceCount + 2 * epochCount);
+    TEST_CHECK(test_archive_count(&reader, 0, dayKey - 1, NULL) == 5); // Sentences before first date have time of day key
+
+    // Range queries
+    const uint64_t epochKey = dayKey + 36150000u; // 10:02:30
+    TEST_CHECK(test_archive_count(&reader, epochKey, epochKey, NULL) == 2);
+    TEST_CHECK(test_archive_count(&reader, epochKey, epochKey, "GPGGA") == 1);
+    TEST_CHECK(test_archive_count(&reader, epochKey, epochKey + 9000, "RMC") == 10);
+    TEST_CHECK(test_archive_count(&reader, epochKey, UINT64_MAX, "GSV") == 0);
+    TEST_CHECK(test_archive_count(&reader, 0, UINT64_MAX, "GSV") == 3);
+    TEST_CHECK(test_archive_count(&reader, dayKey + 40000000u, UINT64_MAX, NULL) == 0); // After last record
+
+    TEST_CHECK(nmea_archive_next(&cursor, NULL) == NMEA_ASSERTION_FAILED);
+    TEST_CHECK(nmea_archive_close_reader(&reader) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_archive_open_reader(NULL, dataPath, indexPath) == NMEA_ASSERTION_FAILED);
+    TEST_CHECK(nmea_archive_open_writer(&writer, NULL, indexPath) == NMEA_ASSERTION_FAILED);
+    remove(dataPath);
+    remove(indexPath);
+}
+
+uint64_t test_stats_type_count(const nmea_stats_counters* counters, const char* id) { // Counter of sentence ID (key packs one character per byte)
+    uint64_t key = 0;
+    for(size_t i = 0; id[i] != '\0'; ++i) {
+        key = (key << 8) | (unsigned char)id[i];
+    }
+    for(size_t i = 0; i < NMEA_STATS_SENTENCE_TYPES; ++i) {
+        if(counters->sentence_types[i].key == key) {
+            return counters->sentence_types[i].count;
+        }
+    }
+    return 0;
+}
+
+void test_stats() {
+    static nmea_stats stats;
+    nmea_parser parser;
+    nmea_init_parser(&parser);
+    nmea_init_stats(&stats);
+#ifndef NMEA_STATS
+    TEST_CHECK(nmea_parser_set_stats(&parser, &stats) == NMEA_STATS_DISABLED);
+    TEST_CHECK(nmea_parser_set_stats(&parser, NULL) == NMEA_SUCCESS);
+#else
+    static nmea_filter filter;
+    TEST_CHECK(nmea_parser_set_stats(&parser, &stats) == NMEA_SUCCESS);
+    nmea_init_filter(&filter, NMEA_FILTER_DENY);
+    nmea_filter_add(&filter, "GSV");
+    nmea_parser_set_filter(&parser, &filter);
+
+    static const char log[] =
+        "xx$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\n" // Skipped bytes, then parsed
+        "$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*0B\n" // Checksum error
+        "$GPRMC,092750.000,A" // Truncated by next sentence
+        "$GPGGA,092751.000,5321.6802,N,00630.3371,W,1,8,1.03,61.7,M,55.3,M,,*75\n"
+        "$GPGSV,3,3,11,29,09,301,24,16,09,020,,36,,,*76\n" // Filtered
+        "$GPGG,1\n"; // Sentence ID too short (no type)
+
+    const int expected[] = { NMEA_SUCCESS, NMEA_CHECKSUM_ERROR, NMEA_MESSAGE_TRUNCATED, NMEA_SUCCESS, NMEA_MESSAGE_FILTERED, NMEA_MESSAGE_ID_LENGTH_INCORRECT };
+    size_t offset = 0;
+    for(size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); ++i) {
+        nmea_message* message = NULL;
+        size_t messageEndIndex;
+        const int status = nmea_parser_parse_message(&parser, log + offset, &message, &messageEndIndex, 0, NULL);
+        TEST_CHECK(status == expected[i]);
+        if(status == NMEA_SUCCESS) {
+            nmea_destroy_message(&message);
+        }
+        offset += messageEndIndex;
+    }
+    TEST_CHECK(log[offset] == '\0');
+
+    nmea_stats_counters snapshot;
+    TEST_CHECK(nmea_stats_snapshot(&stats, &snapshot) == NMEA_SUCCESS);
+    TEST_CHECK(snapshot.sentences == 6 && snapshot.parsed == 2 && snapshot.skipped_bytes == 2 && snapshot.bytes == offset);
+    TEST_CHECK(snapshot.errors[0] == 0);
+    TEST_CHECK(snapshot.errors[-NMEA_CHECKSUM_ERROR] == 1 && snapshot.errors[-NMEA_MESSAGE_TRUNCATED] == 1);
+    TEST_CHECK(snapshot.errors[-NMEA_MESSAGE_FILTERED] == 1 && snapshot.errors[-NMEA_MESSAGE_ID_LENGTH_INCORRECT] == 1);
+    TEST_CHECK(NMEA_STATS_ERROR_CODES > -NMEA_LAST_ERROR); // Lowest return value has its own counter
+    TEST_CHECK(test_stats_type_count(&snapshot, "GPGGA") == 2 && test_stats_type_count(&snapshot, "GPGSA") == 1);
+    TEST_CHECK(test_stats_type_count(&snapshot, "GPRMC") == 1 && test_stats_type_count(&snapshot, "GPGSV") == 1);
+    TEST_CHECK(test_stats_type_count(&snapshot, "GPGG") == 0 && snapshot.other_sentence_types == 0);
+    TEST_CHECK(snapshot.field_counts[14] == 2);
+
+    // Reset zeroes counters; Parsing continues from there
+    TEST_CHECK(nmea_stats_reset(&stats) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_stats_snapshot(&stats, &snapshot) == NMEA_SUCCESS);
+    TEST_CHECK(snapshot.sentences == 0 && snapshot.parsed == 0 && snapshot.bytes == 0 && snapshot.skipped_bytes == 0);
+    TEST_CHECK(snapshot.errors[-NMEA_CHECKSUM_ERROR] == 0 && snapshot.field_counts[14] == 0);
+    TEST_CHECK(test_stats_type_count(&snapshot, "GPGGA") == 0 && test_stats_type_count(&snapshot, "GPRMC") == 0);
+
+    nmea_message* message;
+    size_t messageEndIndex;
+    TEST_CHECK(nmea_parser_parse_message(&parser, log + 2, &message, &messageEndIndex, 0, NULL) == NMEA_SUCCESS);
+    nmea_destroy_message(&message);
+    TEST_CHECK(nmea_stats_snapshot(&stats, &snapshot) == NMEA_SUCCESS);
+    TEST_CHECK(snapshot.sentences == 1 && snapshot.parsed == 1 && test_stats_type_count(&snapshot, "GPGGA") == 1);
+#endif
+}
+
+void test_resync() {
+    // Sentence cut off by next begin delimiter: every entry point reports NMEA_MESSAGE_TRUNCATED at the new delimiter
+    static const struct {
+        const char* str;
+        size_t nextBegin;
+    } cases[] = {
+        { "$GPGGA,0927$GPRMC,092750", 11 }, // Mid field
+        { "$GPGSA,A,3*0$GPRMC,0927", 12 }, // In checksum
+        { "$GPGGA,1,2!AIVDM,1", 10 }, // Encapsulated sentence begins
+        { "$GPG$GPRMC,1", 4 } // In sentence ID
+    };
+    for(size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        const char* str = cases[i].str;
+        const size_t length = strlen(str);
+        nmea_message* message;
+        size_t messageEndIndex;
+        TEST_CHECK(nmea_parse_message(str, &message, &messageEndIndex, 0, NULL) == NMEA_MESSAGE_TRUNCATED && messageEndIndex == cases[i].nextBegin);
+        TEST_CHECK(nmea_parse_message(str + messageEndIndex, &message, &messageEndIndex, 0, NULL) == NMEA_MESSAGE_END_DELIMITER_NOT_FOUND && messageEndIndex == 0); // Rest needs more data
+        TEST_CHECK(test_buffer_status(str, 1) == NMEA_MESSAGE_TRUNCATED);
+        TEST_CHECK(test_stream_status(str, 0) == NMEA_MESSAGE_TRUNCATED); // Second sentence stays pending
+
+        nmea_batch batch;
+        nmea_init_batch(&batch);
+        TEST_CHECK(nmea_parse_batch(str, length, &batch, 0) == NMEA_SUCCESS && batch.message_count == 2);
+        if(batch.message_count == 2) {
+            TEST_CHECK(batch.statuses[0] == NMEA_MESSAGE_TRUNCATED && batch.message_offsets[0] == 0 && batch.message_lengths[0] == cases[i].nextBegin);
+            TEST_CHECK(batch.statuses[1] == NMEA_MESSAGE_END_DELIMITER_NOT_FOUND && batch.message_offsets[1] == cases[i].nextBegin);
+        }
+        nmea_destroy_batch(&batch);
+
+        TEST_CHECK(nmea_resync(str + 1, length - 1) == cases[i].nextBegin - 1);
+    }
+
+    // Binary noise (UBX frame bytes, NUL) before next sentence
+    char noise[96];
+    for(size_t i = 0; i < sizeof(noise); ++i) {
+        noise[i] = (char)(i % 3 == 0 ? 0 : 0xB5 + i); // Never "$" or "!"
+    }
+    TEST_CHECK(nmea_resync(noise, sizeof(noise)) == sizeof(noise)); // None
+    TEST_CHECK(nmea_resync(noise, 0) == 0);
+    for(size_t position = 0; position < sizeof(noise); ++position) { // Every vector lane and alignment
+        const char saved = noise[position];
+        noise[position] = position % 2 == 0 ? '$' : '!';
+        TEST_CHECK(nmea_resync(noise, sizeof(noise)) == position);
+        TEST_CHECK(nmea_resync(noise, position) == position); // Delimiter just past length is not seen
+        noise[position] = saved;
+    }
+}
+
+void test_allocator() {
+    static const char gpgga[] = "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n";
+
+    nmea_parser parser;
+    nmea_init_parser(&parser);
+    nmea_message* message;
+    nmea_message* firstMessage;
+    size_t messageEndIndex;
+
+    // Arena: messages live in caller buffer until reset, then the same memory is reused
+    static char arenaBuffer[4096];
+    nmea_arena arena;
+    nmea_allocator arenaAllocator;
+    TEST_CHECK(nmea_init_arena(&arena, arenaBuffer + 1, sizeof(arenaBuffer) - 1) == NMEA_SUCCESS); // Misaligned on purpose
+    TEST_CHECK(nmea_init_arena_allocator(&arenaAllocator, &arena) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_parser_set_allocator(&parser, &arenaAllocator) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_parser_parse_message(&parser, gpgga, &firstMessage, &messageEndIndex, 1, NULL) == NMEA_SUCCESS);
+    TEST_CHECK(firstMessage != NULL && firstMessage->allocator == &arenaAllocator && firstMessage->value_count == 14);
+    TEST_CHECK((char*)firstMessage >= arenaBuffer && (char*)firstMessage < arenaBuffer + sizeof(arenaBuffer));
+    TEST_CHECK((uintptr_t)firstMessage % 16 == 0);
+    TEST_CHECK(strcmp(firstMessage->first_value->value, "092750.000") == 0 && strcmp(firstMessage->last_value->value, "") == 0);
+    const size_t firstUsed = arena.used;
+    TEST_CHECK(firstUsed > 0 && firstUsed <= arena.capacity);
+
+    TEST_CHECK(nmea_parser_parse_message(&parser, gpgga, &message, &messageEndIndex, 1, NULL) == NMEA_SUCCESS);
+    const size_t secondUsed = arena.used;
+    TEST_CHECK(message != firstMessage && secondUsed > firstUsed);
+    TEST_CHECK(nmea_destroy_message(&message) == NMEA_SUCCESS && arena.used == secondUsed); // Released only by reset
+
+    TEST_CHECK(nmea_reset_arena(&arena) == NMEA_SUCCESS && arena.used == 0);
+    TEST_CHECK(nmea_parser_parse_message(&parser, gpgga, &message, &messageEndIndex, 1, NULL) == NMEA_SUCCESS);
+    TEST_CHECK(message == firstMessage && arena.used == firstUsed);
+    TEST_CHECK(message->value_count == 14 && strcmp(message->first_value->next_value->value, "5321.6802") == 0);
+
+    // Arena exhaustion fails parsing (message or any of its values), never writes past capacity
+    for(size_t capacity = 0; capacity < firstUsed; capacity += 7) {
+        TEST_CHECK(nmea_init_arena(&arena, arenaBuffer, capacity) == NMEA_SUCCESS);
+        message = (nmea_message*)arenaBuffer;
+        TEST_CHECK(nmea_parser_parse_message(&parser, gpgga, &message, &messageEndIndex, 1, NULL) == NMEA_ALLOCATION_ERROR);
+        TEST_CHECK(message == NULL && arena.used <= arena.capacity);
+    }
+    TEST_CHECK(nmea_init_arena(&arena, arenaBuffer, firstUsed) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_parser_parse_message(&parser, gpgga, &message, &messageEndIndex, 1, NULL) == NMEA_SUCCESS); // Exact fit
+    TEST_CHECK(arena.used == arena.capacity);
+
+    // Pool: fixed number of aligned blocks, released blocks are reused first
+    static char poolBuffer[3 * 112 + 16 + 3];
+    nmea_pool pool;
+    nmea_allocator poolAllocator;
+    TEST_CHECK(nmea_init_pool(&pool, poolBuffer + 3, sizeof(poolBuffer) - 3, 100) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_init_pool_allocator(&poolAllocator, &pool) == NMEA_SUCCESS);
+    TEST_CHECK(pool.block_size == 112 && pool.block_count == 3); // Block size rounded up to 16 byte alignment
+    void* blocks[3];
+    for(size_t i = 0; i < 3; ++i) {
+        blocks[i] = poolAllocator.allocate(poolAllocator.context, i == 0 ? 100 : 1);
+        TEST_CHECK(blocks[i] != NULL && (uintptr_t)blocks[i] % 16 == 0);
+        TEST_CHECK((char*)blocks[i] >= poolBuffer + 3 && (char*)blocks[i] + 112 <= poolBuffer + sizeof(poolBuffer));
+    }
+    TEST_CHECK(blocks[0] != blocks[1] && blocks[1] != blocks[2] && blocks[0] != blocks[2]);
+    TEST_CHECK(poolAllocator.allocate(poolAllocator.context, 1) == NULL); // Exhausted
+    poolAllocator.deallocate(poolAllocator.context, blocks[1]);
+    poolAllocator.deallocate(poolAllocator.context, blocks[2]);
+    TEST_CHECK(poolAllocator.allocate(poolAllocator.context, 113) == NULL); // Larger than block
+    TEST_CHECK(poolAllocator.allocate(poolAllocator.context, 1) == blocks[2]); // Last released first
+    TEST_CHECK(poolAllocator.allocate(poolAllocator.context, 1) == blocks[1]);
+    TEST_CHECK(poolAllocator.allocate(poolAllocator.context, 1) == NULL);
+    TEST_CHECK(nmea_reset_pool(&pool) == NMEA_SUCCESS);
+    TEST_CHECK(poolAllocator.allocate(poolAllocator.context, 1) == blocks[0]);
+
+    // Pool behind parser: destroyed message returns all its blocks, exhaustion releases partially built message
+    static char messagePoolBuffer[40 * (NMEA_MESSAGE_MAX_LENGTH + 1 + 16)];
+    TEST_CHECK(nmea_init_pool(&pool, messagePoolBuffer, sizeof(messagePoolBuffer), NMEA_MESSAGE_MAX_LENGTH + 1) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_parser_set_allocator(&parser, &poolAllocator) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_parser_parse_message(&parser, gpgga, &firstMessage, &messageEndIndex, 1, NULL) == NMEA_SUCCESS);
+    const size_t blocksPerMessage = pool.next_unused;
+    TEST_CHECK(blocksPerMessage == 1 + 2 * 14 && 2 * blocksPerMessage > pool.block_count); // Message + value and its string per field
+    TEST_CHECK(nmea_destroy_message(&firstMessage) == NMEA_SUCCESS && firstMessage == NULL);
+    TEST_CHECK(nmea_parser_parse_message(&parser, gpgga, &message, &messageEndIndex, 1, NULL) == NMEA_SUCCESS);
+    TEST_CHECK(pool.next_unused == blocksPerMessage && pool.free_list == NULL); // Built from released blocks only
+    TEST_CHECK(message->value_count == 14 && strcmp(message->first_value->value, "092750.000") == 0);
+    TEST_CHECK(nmea_parser_parse_message(&parser, gpgga, &firstMessage, &messageEndIndex, 1, NULL) == NMEA_ALLOCATION_ERROR);
+    TEST_CHECK(firstMessage == NULL && pool.next_unused == pool.block_count);
+    nmea_destroy_message(&message);
+    TEST_CHECK(nmea_parser_parse_message(&parser, gpgga, &message, &messageEndIndex, 1, NULL) == NMEA_SUCCESS);
+    nmea_destroy_message(&message);
+
+    // NULL allocator restores malloc / free
+    TEST_CHECK(nmea_parser_set_allocator(&parser, NULL) == NMEA_SUCCESS);
+    TEST_CHECK(nmea_parser_parse_message(&parser, gpgga, &message, &messageEndIndex, 1, NULL) == NMEA_SUCCESS);
+    TEST_CHECK(message->allocator == NULL);
+    TEST_CHECK((char*)message < messagePoolBuffer || (char*)message >= messagePoolBuffer + sizeof(messagePoolBuffer));
+    nmea_destroy_message(&message);
+}
 
 int main() {
     static const char testString[] =
@@ -20,19 +1348,44 @@ int main() {
     size_t messageEndIndex = 0;
     size_t lastMessageEndIndex = 0;
     nmea_message* message;
-    while(nmea_parse_message(testString + lastMessageEndIndex, &message, &messageEndIndex, 0, NULL) == NMEA_SUCCESS) {
-        printf("Value count: %zu\n", message->value_count);
+    while(testString[lastMessageEndIndex] != '\0') {
+        if(nmea_parse_message(testString + lastMessageEndIndex, &message, &messageEndIndex, 0, NULL) == NMEA_SUCCESS) {
+            printf("Value count: %zu\n", message->value_count);
 
-        char* test_str;
-        nmea_message_to_string(message, &test_str);
+            char* test_str;
+            nmea_message_to_string(message, &test_str);
 
-        printf("%s - %zu\n", test_str, message->value_count);
+            printf("%s - %zu\n", test_str, message->value_count);
 
-        nmea_destroy_message_string(&test_str);
+            nmea_destroy_message_string(&test_str);
 
-        nmea_destroy_message(&message);
+            nmea_destroy_message(&message);
+        }
 
-        lastMessageEndIndex += messageEndIndex;
+        if(messageEndIndex == 0) { // Last message is not terminated
+            break;
+        }
+        lastMessageEndIndex += messageEndIndex; // Set on errors too
     }
-    return -1;
+
+    test_scan();
+    test_converters();
+    test_field_view();
+    test_stream();
+    test_checksum();
+    test_batch();
+    test_resync();
+    test_filter();
+    test_allocator();
+    test_registry();
+    test_decode();
+    test_epoch();
+    test_writer();
+    test_ais();
+    test_parallel();
+    test_archive();
+    test_stats();
+
+    printf("%s\n", failures == 0 ? "All tests passed" : "Some tests failed");
+    return failures == 0 ? 0 : 1;
 }
\ No newline at end of file